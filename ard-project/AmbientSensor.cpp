@@ -0,0 +1,34 @@
+#include "Arduino.h"
+#include "AmbientSensor.h"
+#include "Timing.h"
+
+AmbientSensor::AmbientSensor(DHT &dht, uint32_t period) : dht(dht) {
+    this->period = period;
+    this->sampled = false;
+    this->failures = 0;
+    this->last.temperature = NAN;
+    this->last.humidity = NAN;
+    this->last.time = 0;
+}
+
+const AmbientSample &AmbientSensor::sample() {
+    if (this->sampled && timeElapsed(this->last.time) < this->period) {
+        return this->last;
+    }
+
+    //a failed read is cached too, the sensor is not asked again before the period ends
+    this->sampled = true;
+    this->last.time = timeNow();
+    this->last.temperature = dht.readTemperature();
+    this->last.humidity = dht.readHumidity();
+
+    if (isnan(this->last.temperature) || isnan(this->last.humidity)) {
+        this->failures++;
+    }
+
+    return this->last;
+}
+
+uint16_t AmbientSensor::getFailures() {
+    return this->failures;
+}
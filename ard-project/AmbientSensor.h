@@ -0,0 +1,47 @@
+#ifndef _AMBIENT_SENSOR_H
+#define _AMBIENT_SENSOR_H
+
+#include "DHT.h"
+
+/**
+ * One reading of the DHT sensor
+ */
+struct AmbientSample {
+    float temperature;  //degrees Celsius, NAN if the read failed
+    float humidity;     //percent, NAN if the read failed
+    uint32_t time;      //timeNow() of the read
+};
+
+/**
+ * Reads the DHT sensor at most once per sampling period and shares the sample
+ * between the controllers, one transaction gives both temperature and humidity.
+ */
+class AmbientSensor {
+private:
+    DHT &dht;
+    uint32_t period;
+    bool sampled;
+    uint16_t failures;
+    AmbientSample last;
+
+public:
+    /**
+     * @param dht Currently used DHT sensor
+     * @param period Sampling period in milliseconds
+     */
+    AmbientSensor(DHT &dht, uint32_t period);
+
+    /**
+     * Reads the sensor if the last sample is older than the sampling period.
+     *
+     * @return Current sample, valid until the next call
+     */
+    const AmbientSample &sample();
+
+    /**
+     * @return Number of failed reads
+     */
+    uint16_t getFailures();
+};
+
+#endif
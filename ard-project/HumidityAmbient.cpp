@@ -14,11 +14,30 @@
 #define HUMIDIFIER_VALUE 2
 #define SMS_VALUE 1
 
+//humidifier_sms = Humidifier(2) + Sms(1)
+const Transition HumidityAmbient::TABLE[STATES * CONDITIONS] PROGMEM = {
+        //O
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {LOW_1, LOCK_LOW_1, HS_LOW},                            //C_LOW
+        {EMERGENCY, LOCK_EMERGENCY, HS_HIGH + HS_EMERGENCY},    //C_HIGH
+        //LOW_1
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {LOW_2, LOCK_LOW_2, HS_LOW},                            //C_LOW
+        {O, LOCK_0, HS_0},                                      //C_HIGH
+        //LOW_2
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, HS_LOW + HS_EMERGENCY},     //C_LOW
+        {O, LOCK_0, HS_0},                                      //C_HIGH
+        //EMERGENCY
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, HS_LOW + HS_EMERGENCY},     //C_LOW
+        {EMERGENCY, LOCK_EMERGENCY, HS_HIGH + HS_EMERGENCY},    //C_HIGH
+};
+
 /**
  * Default constructor
  */
-HumidityAmbient::HumidityAmbient() {
-    HumidityAmbient(100, 0);
+HumidityAmbient::HumidityAmbient() : HumidityAmbient(100, 0) {
 }
 
 /**
@@ -34,6 +53,7 @@ HumidityAmbient::HumidityAmbient(int8_t humidity_max, int8_t humidity_min) {
     this->humidity_min = humidity_min;
     this->lock = LOCK_0;
     this->humidifier_sms = HS_0;
+    STATE = O;
 }
 
 /**
@@ -71,65 +91,25 @@ int8_t HumidityAmbient::getHumidifierSms() {
 }
 
 
-int8_t HumidityAmbient::readHumidity(DHT dht) {
-    int8_t measured = dht.readHumidity();
-
-    switch (STATE) {
-        case O:
-            if (measured < this->humidity_min) { //low humidity 1 -> humidifier TRUE, sms FALSE
-                NEXT_STATE = LOW_1;
-                this->lock = LOCK_LOW_1;
-                this->humidifier_sms = HS_LOW;
-            } else if (measured > this->humidity_max) { //high humidity E -> humidifier FALSE, sms TRUE
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_HIGH + HS_EMERGENCY;
-            } else {
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case LOW_1:
-            if (measured < this->humidity_min) { //low humidity 2 -> humidifier TRUE, sms FALSE
-                NEXT_STATE = LOW_2;
-                this->lock = LOCK_LOW_2;
-                this->humidifier_sms = HS_LOW;
-            } else { //humidity OK
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case LOW_2:
-            if (measured < this->humidity_min) { //low humidity E -> humidifier TRUE, sms TRUE
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_LOW + HS_EMERGENCY;
-            } else { //humidity OK
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case EMERGENCY:
-            if (measured > this->humidity_max) { //high humidity E -> humidifier FALSE, sms TRUE
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_HIGH + HS_EMERGENCY;
-            } else if (measured < humidity_min) { //low humidity E -> humidifier TRUE, sms TRUE
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_LOW + HS_EMERGENCY;
-            } else { //humidity OK
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
+bool HumidityAmbient::readHumidity(const AmbientSample &sample) {
+    if (isnan(sample.humidity)) {
+        this->lock = LOCK_0;
+        return false;
+    }
+
+    int8_t measured = (int8_t) sample.humidity;
+    uint8_t condition = C_OK;
+
+    if (measured < this->humidity_min) {
+        condition = C_LOW;
+    } else if (measured > this->humidity_max) {
+        condition = C_HIGH;
     }
 
-    STATE = NEXT_STATE;
+    Transition transition = readTransition(TABLE, CONDITIONS, STATE, condition);
+    STATE = (states) transition.next;
+    this->lock = transition.lock;
+    this->humidifier_sms = transition.outputs;
 
-    return measured;
+    return true;
 }
@@ -1,7 +1,8 @@
 #ifndef _HUMIDITY_AMBIENT_H
 #define _HUMIDITY_AMBIENT_H
 
-#include "DHT.h"
+#include "AmbientSensor.h"
+#include "StateTable.h"
 
 class HumidityAmbient {
 private:
@@ -9,8 +10,11 @@ private:
     int8_t humidity_min;
     int8_t lock;
     int8_t humidifier_sms;
-    enum states {O, LOW_1, LOW_2, EMERGENCY};
-    enum states STATE, NEXT_STATE;
+    enum states {O, LOW_1, LOW_2, EMERGENCY, STATES};
+    enum states STATE;
+
+    enum conditions {C_OK, C_LOW, C_HIGH, CONDITIONS};
+    static const Transition TABLE[STATES * CONDITIONS];
 public:
     HumidityAmbient();
 
@@ -31,13 +35,13 @@ public:
 
 
     /**
-     * Measures current temperature.
-     * Switches states accordingly.
+     * Evaluates the humidity of a sample.
+     * Switches states accordingly, a failed read keeps the state and outputs and sets the shortest lock.
      *
-     * @param dht Currently used DHT sensor
-     * @return Measured humidity
+     * @param sample Current sample of the DHT sensor
+     * @return False if the sample has no humidity
      */
-    int8_t readHumidity(DHT dht);
+    bool readHumidity(const AmbientSample &sample);
 
 };
 
@@ -15,8 +15,23 @@
 
 #define MAX_MEASURED 1023.0
 
-HumiditySoil::HumiditySoil() {
-    HumiditySoil(50, 0);
+//humidifier_sms = Humidifier(2) + Sms(1)
+const Transition HumiditySoil::TABLE[STATES * CONDITIONS] PROGMEM = {
+        //O
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {LOW_1, LOCK_LOW_1, HS_LOW},                            //C_LOW
+        //LOW_1
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {LOW_2, LOCK_LOW_2, HS_LOW},                            //C_LOW
+        //LOW_2
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, HS_LOW + HS_EMERGENCY},     //C_LOW
+        //EMERGENCY
+        {O, LOCK_0, HS_0},                                      //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, HS_LOW + HS_EMERGENCY},     //C_LOW
+};
+
+HumiditySoil::HumiditySoil() : HumiditySoil(50, 0) {
 }
 
 HumiditySoil::HumiditySoil(int8_t humidity_min, int8_t sensor_pin) {
@@ -24,6 +39,7 @@ HumiditySoil::HumiditySoil(int8_t humidity_min, int8_t sensor_pin) {
     this->lock = LOCK_0;
     this->humidifier_sms = HS_0;
     this->sensor_pin = sensor_pin;
+    STATE = O;
 }
 
 void HumiditySoil::setHumidityMin(int8_t humidity_min) {
@@ -61,53 +77,10 @@ int8_t HumiditySoil::readHumidity() {
 
     int8_t humidity = (int8_t) (100 - measured); //humidity = 100 - (avg of 100 measurements)
 
-    switch (STATE) {
-        case O:
-            if (humidity < this->humidity_min) { //humidity low -> LOW_1
-                NEXT_STATE = LOW_1;
-                this->lock = LOCK_LOW_1;
-                this->humidifier_sms = HS_LOW;
-            } else { //humidity OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case LOW_1:
-            if (humidity < this->humidity_min) { //humidity low -> LOW_2
-                NEXT_STATE = LOW_2;
-                this->lock = LOCK_LOW_2;
-                this->humidifier_sms = HS_LOW;
-            } else { //humidity OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case LOW_2:
-            if (humidity < this->humidity_min) { //humidity low -> EMERGENCY
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_LOW + HS_EMERGENCY;
-            } else { //humidity OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-        case EMERGENCY:
-            if (humidity < this->humidity_min) { //humidity l0w -> stay in EMERGENCY
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->humidifier_sms = HS_LOW + HS_EMERGENCY;
-            } else { //humidity OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->humidifier_sms = HS_0;
-            }
-            break;
-    }
+    Transition transition = readTransition(TABLE, CONDITIONS, STATE, humidity < this->humidity_min ? C_LOW : C_OK);
+    STATE = (states) transition.next;
+    this->lock = transition.lock;
+    this->humidifier_sms = transition.outputs;
 
     return humidity;
-
 }
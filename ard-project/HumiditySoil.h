@@ -1,6 +1,8 @@
 #ifndef _HUMIDITY_SOIL_H
 #define _HUMIDITY_SOIL_H
 
+#include "StateTable.h"
+
 class HumiditySoil {
 private:
     int8_t humidity_min;
@@ -8,8 +10,11 @@ private:
     uint8_t lock;
     int8_t humidifier_sms;
     int8_t sensor_pin;
-    enum states {O, LOW_1, LOW_2, EMERGENCY};
-    enum states STATE, NEXT_STATE;
+    enum states {O, LOW_1, LOW_2, EMERGENCY, STATES};
+    enum states STATE;
+
+    enum conditions {C_OK, C_LOW, CONDITIONS};
+    static const Transition TABLE[STATES * CONDITIONS];
 public:
     HumiditySoil();
     HumiditySoil(int8_t humidity_min, int8_t sensor_pin);
@@ -0,0 +1,126 @@
+#include "Arduino.h"
+#include "Scheduler.h"
+
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
+Scheduler::Scheduler() {
+    this->size = 0;
+    this->idle_millis = 0;
+}
+
+void Scheduler::siftUp(uint8_t index) {
+    while (index > 0) {
+        uint8_t parent = (index - 1) / 2;
+
+        if (!timeBefore(heap[index].deadline, heap[parent].deadline)) {
+            break;
+        }
+
+        Task tmp = heap[index];
+        heap[index] = heap[parent];
+        heap[parent] = tmp;
+        index = parent;
+    }
+}
+
+void Scheduler::siftDown(uint8_t index) {
+    while (true) {
+        uint8_t smallest = index;
+        uint8_t left = 2 * index + 1;
+        uint8_t right = left + 1;
+
+        if (left < this->size && timeBefore(heap[left].deadline, heap[smallest].deadline)) {
+            smallest = left;
+        }
+        if (right < this->size && timeBefore(heap[right].deadline, heap[smallest].deadline)) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+
+        Task tmp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = tmp;
+        index = smallest;
+    }
+}
+
+bool Scheduler::schedule(TaskFunction function, uint8_t arg, uint32_t delay) {
+    if (this->size == SCHEDULER_TASKS) {
+        return false;
+    }
+
+    heap[this->size].deadline = timeNow() + delay;
+    heap[this->size].function = function;
+    heap[this->size].arg = arg;
+    siftUp(this->size++);
+    return true;
+}
+
+bool Scheduler::cancel(TaskFunction function, uint8_t arg) {
+    for (uint8_t i = 0; i < this->size; i++) {
+        if (heap[i].function == function && heap[i].arg == arg) {
+            //last task takes the place of the removed one
+            heap[i] = heap[--this->size];
+            if (i < this->size) {
+                siftDown(i);
+                siftUp(i);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Scheduler::pending(TaskFunction function, uint8_t arg) {
+    for (uint8_t i = 0; i < this->size; i++) {
+        if (heap[i].function == function && heap[i].arg == arg) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Scheduler::sleep(uint32_t ms) {
+#ifdef __AVR__
+    //idle mode keeps timers running, timer0 wakes the CPU at least every ~1 ms
+    (void) ms;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#else
+    //host simulation, the virtual clock jumps to the deadline
+    delay(ms);
+#endif
+}
+
+void Scheduler::run() {
+    //run due tasks, a task may schedule more
+    while (this->size > 0 && timeReached(heap[0].deadline)) {
+        Task task = heap[0];
+
+        heap[0] = heap[--this->size];
+        siftDown(0);
+        task.function(task.arg);
+    }
+
+    if (this->size == 0) {
+        return;
+    }
+
+    uint32_t start = timeNow();
+    sleep(timeUntil(heap[0].deadline));
+    this->idle_millis += timeElapsed(start);
+}
+
+uint32_t Scheduler::getIdleMillis() {
+    return this->idle_millis;
+}
+
+uint8_t Scheduler::getSize() {
+    return this->size;
+}
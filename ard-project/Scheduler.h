@@ -0,0 +1,86 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include "Arduino.h"
+#include "Timing.h"
+
+#define SCHEDULER_TASKS 8
+
+/**
+ * Task function, arg is the value given to Scheduler::schedule()
+ */
+typedef void (*TaskFunction)(uint8_t arg);
+
+/**
+ * Cooperative scheduler of one-shot tasks kept in a min-heap by deadline.
+ * Periodic work reschedules itself. Between deadlines the CPU sleeps.
+ *
+ * Deadlines are compared with the helpers of Timing.h, so millis() overflow is safe
+ * as long as every delay is less than 2^31 ms (about 24.8 days).
+ */
+class Scheduler {
+private:
+    struct Task {
+        uint32_t deadline;
+        TaskFunction function;
+        uint8_t arg;
+    };
+
+    Task heap[SCHEDULER_TASKS];
+    uint8_t size;
+    uint32_t idle_millis;
+
+    void siftUp(uint8_t index);
+
+    void siftDown(uint8_t index);
+
+    /**
+     * Sleeps until an interrupt or the deadline, whichever is first
+     *
+     * @param ms Time left until the next deadline
+     */
+    void sleep(uint32_t ms);
+
+public:
+    Scheduler();
+
+    /**
+     * @param function Task to run
+     * @param arg Argument of function
+     * @param delay Milliseconds from now
+     * @return False if the scheduler is full
+     */
+    bool schedule(TaskFunction function, uint8_t arg, uint32_t delay);
+
+    /**
+     * @param function Task to remove
+     * @param arg Argument it was scheduled with
+     * @return False if no such task is scheduled
+     */
+    bool cancel(TaskFunction function, uint8_t arg);
+
+    /**
+     * @param function Task
+     * @param arg Argument it was scheduled with
+     * @return True if the task is scheduled
+     */
+    bool pending(TaskFunction function, uint8_t arg);
+
+    /**
+     * Runs every task that is due, then sleeps until the next deadline.
+     * Meant to be called from loop().
+     */
+    void run();
+
+    /**
+     * @return Milliseconds spent sleeping
+     */
+    uint32_t getIdleMillis();
+
+    /**
+     * @return Number of scheduled tasks
+     */
+    uint8_t getSize();
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _STATE_TABLE_H
+#define _STATE_TABLE_H
+
+#include "Arduino.h"
+
+/**
+ * One row of a controller transition table.
+ * Tables are laid out state by state, one row per condition, and live in PROGMEM.
+ */
+struct Transition {
+    uint8_t next;       //next state
+    uint8_t lock;       //minutes until the next measurement
+    uint8_t outputs;    //output bitmask of the controller
+};
+
+/**
+ * @param table Transition table in PROGMEM
+ * @param conditions Number of conditions (rows per state)
+ * @param state Current state
+ * @param condition Condition of the measurement
+ * @return Row of table for state and condition
+ */
+inline Transition readTransition(const Transition *table, uint8_t conditions, uint8_t state, uint8_t condition) {
+    const Transition *row = table + state * conditions + condition;
+    Transition transition;
+
+    transition.next = pgm_read_byte(&row->next);
+    transition.lock = pgm_read_byte(&row->lock);
+    transition.outputs = pgm_read_byte(&row->outputs);
+    return transition;
+}
+
+#endif
@@ -21,8 +21,47 @@
 #define BACKUP_VALUE 2
 #define SMS_VALUE 1
 
-Temperature::Temperature() {
-    Temperature(DEFAULT_MAX, DEFAULT_MIN, DEFAULT_MAIN, DEFAULT_BACKUP);
+//main_backup_sms = Main(4) + Backup(2) + Sms(1)
+const Transition Temperature::TABLE[STATES * CONDITIONS] PROGMEM = {
+        //O
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW_WORSE
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH_WORSE
+        //LOW_1
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW
+        {LOW_2, LOCK_LOW_2, LOW_MBS},                           //C_LOW_WORSE
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH_WORSE
+        //LOW_2
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, LOW_MBS + SMS_VALUE},       //C_LOW
+        {EMERGENCY, LOCK_EMERGENCY, LOW_MBS + SMS_VALUE},       //C_LOW_WORSE
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH_WORSE
+        //HIGH_1
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW_WORSE
+        {HIGH_1, LOCK_HIGH_1, HIGH_MBS},                        //C_HIGH
+        {HIGH_2, LOCK_HIGH_2, HIGH_MBS},                        //C_HIGH_WORSE
+        //HIGH_2
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW
+        {LOW_1, LOCK_LOW_1, LOW_MBS},                           //C_LOW_WORSE
+        {EMERGENCY, LOCK_EMERGENCY, HIGH_MBS + SMS_VALUE},      //C_HIGH
+        {EMERGENCY, LOCK_EMERGENCY, HIGH_MBS + SMS_VALUE},      //C_HIGH_WORSE
+        //EMERGENCY
+        {O, LOCK_0, OK_MBS},                                    //C_OK
+        {EMERGENCY, LOCK_EMERGENCY, LOW_MBS + SMS_VALUE},       //C_LOW
+        {EMERGENCY, LOCK_EMERGENCY, LOW_MBS + SMS_VALUE},       //C_LOW_WORSE
+        {EMERGENCY, LOCK_EMERGENCY, HIGH_MBS + SMS_VALUE},      //C_HIGH
+        {EMERGENCY, LOCK_EMERGENCY, HIGH_MBS + SMS_VALUE},      //C_HIGH_WORSE
+};
+
+Temperature::Temperature() : Temperature(DEFAULT_MAX, DEFAULT_MIN, DEFAULT_MAIN, DEFAULT_BACKUP) {
 }
 
 
@@ -66,116 +105,29 @@ int8_t Temperature::getMainBackupSms() {
     return this->main_backup_sms;
 }
 
-int8_t Temperature::readTemperature(DHT dht) {
-    int8_t measured = dht.readTemperature();
-
-    switch (STATE)  {
-        case O: //state - OK
-            if (measured < this->temperature_min) { //temperature too low -> LOW_1
-                NEXT_STATE = LOW_1;
-                this->lock = LOCK_LOW_1;
-                this->main_backup_sms = LOW_MBS;
-            } else if (measured > this->temperature_max) { //temperature too high -> HIGH_1
-                NEXT_STATE = HIGH_1;
-                this->lock = LOCK_HIGH_1;
-                this->main_backup_sms = HIGH_MBS;
-            } else { //temperature OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
-        case LOW_1: //state - LOW_1
-            if (measured < this->temperature_min) { //temperature too low
-                if (measured <= temperature_last) { //not rising -> LOW_2
-                    NEXT_STATE = LOW_2;
-                    this->lock = LOCK_LOW_2;
-                    this->main_backup_sms = LOW_MBS;
-                } else { //rising -> stay in LOW_1
-                    NEXT_STATE = LOW_1;
-                    this->lock = LOCK_LOW_1;
-                    this->main_backup_sms = LOW_MBS;
-                }
-            } else if (measured > this->temperature_max) { //temperature too high -> HIGH_1
-                NEXT_STATE = HIGH_1;
-                this->lock = LOCK_HIGH_1;
-                this->main_backup_sms = HIGH_MBS;
-            } else { //temperature OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
-        case LOW_2: //state - LOW_2
-            if (measured < this->temperature_min) { //temperature too low -> EMERGENCY
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->main_backup_sms = LOW_MBS + SMS_VALUE;
-            } else if (measured > this->temperature_max) { //temperature too high -> HIGH_1
-                NEXT_STATE = HIGH_1;
-                this->lock = LOCK_HIGH_1;
-                this->main_backup_sms = HIGH_MBS;
-            } else { //temperature OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
-        case HIGH_1: //state - HIGH_1
-            if (measured < this->temperature_min) { //temperature too low -> LOW_1
-                NEXT_STATE = LOW_1;
-                this->lock = LOCK_LOW_1;
-                this->main_backup_sms = LOW_MBS;
-            } else if (measured > this->temperature_max) { //temperature too high
-                if (measured >= temperature_last) { //still rising -> HIGH_2
-                    NEXT_STATE = HIGH_2;
-                    this->lock = LOCK_HIGH_2;
-                    this->main_backup_sms = HIGH_MBS;
-                } else { //dropping -> stay in HIGH_1
-                    NEXT_STATE = HIGH_1;
-                    this->lock = LOCK_HIGH_1;
-                    this->main_backup_sms = HIGH_MBS;
-                }
-            } else { //temperature OK -> 0
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
-        case HIGH_2:
-            if (measured > this->temperature_max) {
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->main_backup_sms = HIGH_MBS + SMS_VALUE;
-            } else if (measured < this->temperature_min) {
-                NEXT_STATE = LOW_1;
-                this->lock = LOCK_LOW_1;
-                this->main_backup_sms = LOW_MBS;
-            } else {
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
-        case EMERGENCY:
-            if (measured > this->temperature_max) {
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->main_backup_sms = HIGH_MBS + SMS_VALUE;
-            } else if (measured < temperature_min) {
-                NEXT_STATE = EMERGENCY;
-                this->lock = LOCK_EMERGENCY;
-                this->main_backup_sms = LOW_MBS + SMS_VALUE;
-            } else {
-                NEXT_STATE = O;
-                this->lock = LOCK_0;
-                this->main_backup_sms = OK_MBS;
-            }
-            break;
+uint8_t Temperature::condition(int8_t measured) {
+    if (measured < this->temperature_min) { //too low, worse if not rising
+        return measured <= this->temperature_last ? C_LOW_WORSE : C_LOW;
     }
+    if (measured > this->temperature_max) { //too high, worse if not dropping
+        return measured >= this->temperature_last ? C_HIGH_WORSE : C_HIGH;
+    }
+    return C_OK;
+}
+
+bool Temperature::readTemperature(const AmbientSample &sample) {
+    if (isnan(sample.temperature)) {
+        this->lock = LOCK_0;
+        return false;
+    }
+
+    int8_t measured = (int8_t) sample.temperature;
+    Transition transition = readTransition(TABLE, CONDITIONS, STATE, condition(measured));
 
-    STATE = NEXT_STATE;
+    STATE = (states) transition.next;
+    this->lock = transition.lock;
+    this->main_backup_sms = transition.outputs;
     this->temperature_last = measured;
 
-    return measured;
+    return true;
 }
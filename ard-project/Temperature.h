@@ -1,7 +1,8 @@
 #ifndef _TEMPERATURE_H
 #define _TEMPERATURE_H
 
-#include "DHT.h"
+#include "AmbientSensor.h"
+#include "StateTable.h"
 
 /**
  * @author fousjan1
@@ -18,8 +19,18 @@ private:
     int8_t main_pin;
     int8_t backup_pin;
     int8_t main_backup_sms;
-    enum states {O, LOW_1, LOW_2, HIGH_1, HIGH_2, EMERGENCY};
-    enum states STATE, NEXT_STATE;
+    enum states {O, LOW_1, LOW_2, HIGH_1, HIGH_2, EMERGENCY, STATES};
+    enum states STATE;
+
+    //measurement against limits, *_WORSE = not moving back towards the limits since the last measurement
+    enum conditions {C_OK, C_LOW, C_LOW_WORSE, C_HIGH, C_HIGH_WORSE, CONDITIONS};
+    static const Transition TABLE[STATES * CONDITIONS];
+
+    /**
+     * @param measured Measured temperature
+     * @return Condition of measured
+     */
+    uint8_t condition(int8_t measured);
 
 public:
     Temperature();
@@ -64,13 +75,13 @@ public:
     int8_t getMainBackupSms();
 
     /**
-     * Measures current temperature.
-     * Switches states accordingly.
+     * Evaluates the temperature of a sample.
+     * Switches states accordingly, a failed read keeps the state and outputs and sets the shortest lock.
      *
-     * @param dht Currently used DHT sensor
-     * @return Measured temperature
+     * @param sample Current sample of the DHT sensor
+     * @return False if the sample has no temperature
      */
-    int8_t readTemperature(DHT dht);
+    bool readTemperature(const AmbientSample &sample);
 
 };
 
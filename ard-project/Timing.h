@@ -0,0 +1,63 @@
+#ifndef _TIMING_H
+#define _TIMING_H
+
+#include "Arduino.h"
+
+/**
+ * Elapsed-time helpers on the 32-bit millis() clock.
+ *
+ * Every time is a uint32_t and every comparison is done on the difference of two times,
+ * so the wraparound of millis() after 2^32 ms (about 49.7 days) is harmless
+ * as long as the compared times are less than 2^31 ms (about 24.8 days) apart.
+ * Times must never be kept in int or unsigned int, which are 16 bits on AVR.
+ */
+
+#define MINUTE_MILLIS 60000UL
+
+/**
+ * @return Current millis()
+ */
+inline uint32_t timeNow() {
+    return (uint32_t) millis();
+}
+
+/**
+ * @param start Time taken by timeNow()
+ * @return Milliseconds since start
+ */
+inline uint32_t timeElapsed(uint32_t start) {
+    return timeNow() - start;
+}
+
+/**
+ * @return True if time a comes before time b
+ */
+inline bool timeBefore(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b) < 0;
+}
+
+/**
+ * @param deadline Time
+ * @return True if deadline is now or in the past
+ */
+inline bool timeReached(uint32_t deadline) {
+    return !timeBefore(timeNow(), deadline);
+}
+
+/**
+ * @param deadline Time
+ * @return Milliseconds until deadline, 0 if it is reached
+ */
+inline uint32_t timeUntil(uint32_t deadline) {
+    return timeReached(deadline) ? 0 : deadline - timeNow();
+}
+
+/**
+ * @param minutes Controller lock
+ * @return Lock in milliseconds, computed in 32 bits
+ */
+inline uint32_t timeMinutes(uint8_t minutes) {
+    return minutes * MINUTE_MILLIS;
+}
+
+#endif
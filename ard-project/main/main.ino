@@ -4,13 +4,17 @@
 #include <EEPROM.h>
 
 #include "Arduino.h"
+#include "AmbientSensor.h"
 #include "Temperature.h"
 #include "HumidityAmbient.h"
 #include "HumiditySoil.h"
+#include "Scheduler.h"
+#include "Timing.h"
 
 //DHT sensor
 #define DHT_PIN 27
 #define DHT_TYPE DHT11
+#define DHT_PERIOD 2000
 
 //humidity sensor count
 #define HUMIDITY_SOIL_CNT 2
@@ -46,6 +50,7 @@
 #define SOIL_PUMP_DURATION 15000
 
 //sms
+#define SMS_SENSOR 8
 #define SMS_TEMPERATURE 4
 #define SMS_HUMIDITY_AMBIENT 2
 #define SMS_HUMIDITY_SOIL 1
@@ -58,6 +63,7 @@
 
 //create necessary objects
 DHT dht(DHT_PIN, DHT_TYPE);
+AmbientSensor ambient(dht, DHT_PERIOD);
 Temperature temperature(TEMPERATURE_MAX, TEMPERATURE_MIN, MAIN_HEAT_PIN, BACKUP_HEAT_PIN);
 HumidityAmbient humidity_ambient(HUMIDITY_A_MAX, HUMIDITY_A_MIN);
 HumiditySoil humidity_soil_0(HUMIDITY_S_MIN_0, SOIL_SENSOR_PIN_0);
@@ -69,40 +75,21 @@ Servo servo_1;
 HumiditySoil humidity_soil_array[HUMIDITY_SOIL_CNT] = {humidity_soil_0, humidity_soil_1};
 Servo servo_array[HUMIDITY_SOIL_CNT] = {servo_0, servo_1};
 
-//temperature locks
-uint8_t lock_temperature = temperature.getLock();
-unsigned int temperature_last_millis = 0;
-unsigned int temperature_current_millis = 0;
+//next runs of controllers and pump stops
+Scheduler scheduler;
 
-//ambient humidity locks
-uint8_t lock_humidity_ambient = humidity_ambient.getLock();
-unsigned int h_amb_last_millis = 0;
-unsigned int h_amb_current_millis = 0;
-
-//soil humidity locks
-uint8_t lock_humidity_soil[HUMIDITY_SOIL_CNT] = {humidity_soil_0.getLock(), humidity_soil_1.getLock()};
-unsigned long int h_soil_last_millis[HUMIDITY_SOIL_CNT] = {0, 0};
-unsigned long int h_soil_current_millis[HUMIDITY_SOIL_CNT] = {0, 0};
-
-//humidifier timer
-int humidifier_millis_current = 0;
-int humidifier_millis_last = 0;
-
-//soil pump timer
-int soil_pump_millis_current = 0;
-int soil_pump_millis_last = 0;
-
-//sms and pump flags
+//sms flags
 int8_t sms_status = 0;
-bool run_humidifier = false;
-bool run_humidifier_long = false;
-bool run_soil_pump = false;
+
+void readTemperature(uint8_t);
+void readHAmbient(uint8_t);
+void readHSoil(uint8_t sensor);
 
 void setup() {
 
-    //attach servos
-    servo_0.attach(SERVO_PIN_0);
-    servo_1.attach(SERVO_PIN_1);
+    //attach servos, servo_array holds copies of servo_0 and servo_1 and those are the ones written to
+    servo_array[0].attach(SERVO_PIN_0);
+    servo_array[1].attach(SERVO_PIN_1);
 
     pinMode(MAIN_HEAT_PIN, OUTPUT);
     pinMode(BACKUP_HEAT_PIN, OUTPUT);
@@ -116,168 +103,146 @@ void setup() {
     dht.begin();
 
     Serial.begin(9600);
+
+    //valves closed until a sensor asks for water
+    for (int i = 0; i < HUMIDITY_SOIL_CNT; i++) {
+        servo_array[i].write(SERVO_CLOSED);
+    }
+
+    //first measurements after the initial lock of each controller
+    scheduler.schedule(readTemperature, 0, timeMinutes(temperature.getLock()));
+    scheduler.schedule(readHAmbient, 0, timeMinutes(humidity_ambient.getLock()));
+    for (int i = 0; i < HUMIDITY_SOIL_CNT; i++) {
+        scheduler.schedule(readHSoil, i, timeMinutes(humidity_soil_array[i].getLock()));
+    }
 }
 
 //void sendSms() {
 //
 //}
 
-//run humidifier pump
-void runHumidifier() {
-    humidifier_millis_current = millis();
+//turn off humidifier pump
+void stopHumidifier(uint8_t) {
+    digitalWrite(PUMP_PIN_1, LOW);
+    digitalWrite(PUMP_PIN_2, LOW);
+}
 
-    int duration = HUMIDIFIER_DURATION;
-    if (run_humidifier_long) duration *= 2;
+//run humidifier pump, a running pump gets the new duration
+void runHumidifier(bool run_long) {
+    uint32_t duration = HUMIDIFIER_DURATION;
+    if (run_long) duration *= 2;
 
     //turn on pump
     digitalWrite(PUMP_PIN_1, HIGH);
     digitalWrite(PUMP_PIN_2, LOW);
 
-    //wait for $duration
-    if (humidifier_millis_current - humidifier_millis_last > duration) {
+    scheduler.cancel(stopHumidifier, 0);
+    scheduler.schedule(stopHumidifier, 0, duration);
+}
 
-        //turn off pump and reset flags
-        digitalWrite(PUMP_PIN_1, LOW);
-        digitalWrite(PUMP_PIN_2, LOW);
+//turn off soil pump and close all valves
+void stopSoilPump(uint8_t) {
+    digitalWrite(SOIL_PUMP_PIN_1, LOW);
+    digitalWrite(SOIL_PUMP_PIN_2, LOW);
 
-        run_humidifier = false;
-        run_humidifier_long = false;
+    for (int i = 0; i < HUMIDITY_SOIL_CNT; i++) {
+        servo_array[i].write(SERVO_CLOSED);
     }
-
 }
 
+//run soil pump, a running pump starts its duration again
 void runSoilPump() {
-    soil_pump_millis_current = millis();
-
     //turn on pump
     digitalWrite(SOIL_PUMP_PIN_1, HIGH);
     digitalWrite(SOIL_PUMP_PIN_2, LOW);
 
-    //wait for duration
-    if (soil_pump_millis_current - soil_pump_millis_last > SOIL_PUMP_DURATION) {
-
-        //turn off pump and reset flag
-        digitalWrite(SOIL_PUMP_PIN_1, LOW);
-        digitalWrite(SOIL_PUMP_PIN_2, LOW);
+    scheduler.cancel(stopSoilPump, 0);
+    scheduler.schedule(stopSoilPump, 0, SOIL_PUMP_DURATION);
+}
 
-        run_soil_pump = false;
+void readTemperature(uint8_t) {
+    //read temperature, heat sources stay as they are if the sensor fails
+    if (!temperature.readTemperature(ambient.sample())) {
+        sms_status |= SMS_SENSOR;
+        scheduler.schedule(readTemperature, 0, timeMinutes(temperature.getLock()));
+        return;
+    }
+    uint8_t mbs = temperature.getMainBackupSms();
+
+    //detect main, backup and sms states
+    //stored in MBS as sum of Main(4) + Backup(2) + Sms(1)
+    bool main = mbs & 4;
+    bool backup = mbs & 2;
+    bool sms = mbs & 1;
+
+    //turn on/off heat sources
+    digitalWrite(MAIN_HEAT_PIN, main);
+    digitalWrite(BACKUP_HEAT_PIN, backup);
+    if (sms) {
+        sms_status += SMS_TEMPERATURE;
     }
 
+    //lock handling
+    scheduler.schedule(readTemperature, 0, timeMinutes(temperature.getLock()));
 }
 
-void readTemperature() {
-    // lock handling
-    temperature_current_millis = millis();
-
-    unsigned int lock_millis = lock_temperature * 60 * 1000;
-
-    if (temperature_current_millis - temperature_last_millis > lock_millis) {
-
-        temperature_last_millis = millis();
-
-        //read temperature
-        int temp = temperature.readTemperature(dht);
-        lock_temperature = temperature.getLock();
-        uint8_t mbs = temperature.getMainBackupSms();
-
-        //detect main, backup and sms states
-        //stored in MBS as sum of Main(4) + Backup(2) + Sms(1)
-        bool main = mbs & 4;
-        bool backup = mbs & 2;
-        bool sms = mbs & 1;
-
-        //turn on/off heat sources
-        digitalWrite(MAIN_HEAT_PIN, main);
-        digitalWrite(BACKUP_HEAT_PIN, backup);
-        if (sms) {
-            sms_status += SMS_TEMPERATURE;
-        }
+void readHAmbient(uint8_t) {
+    //read humidity, the humidifier does not run blind if the sensor fails
+    if (!humidity_ambient.readHumidity(ambient.sample())) {
+        sms_status |= SMS_SENSOR;
+        scheduler.schedule(readHAmbient, 0, timeMinutes(humidity_ambient.getLock()));
+        return;
     }
-}
-
-void readHAmbient() {
-    // lock handling
-    h_amb_current_millis = millis();
-
-    unsigned int lock_millis = lock_humidity_ambient * 60 * 1000;
-
-    if (h_amb_current_millis - h_amb_last_millis > lock_millis) {
+    uint8_t hum_sms = humidity_ambient.getHumidifierSms();
 
-        h_amb_last_millis = millis();
+    //detect main, backup and sms states
+    //stored in hum_sms as Humidifier(2) + Sms(1)
+    bool humidifier = hum_sms & 2;
+    bool sms = hum_sms & 1;
 
-        //read humidity
-        humidity_ambient.readHumidity(dht);
-        lock_humidity_ambient = humidity_ambient.getLock();
-        uint8_t hum_sms = humidity_ambient.getHumidifierSms();
-
-        //detect main, backup and sms states
-        //stored in hum_sms as Humidifier(2) + Sms(1)
-        bool humidifier = hum_sms & 2;
-        bool sms = hum_sms & 1;
-
-        //if humidity too low, set flag for humidifier to turn on
-        if (humidifier) {
-            run_humidifier = true;
-            run_humidifier_long = (humidity_ambient.getState() > 1); // if state LOW_2 || Emergency, set flag for longer humidifier run
-        }
-
-        if (sms) {
-            sms_status += SMS_HUMIDITY_AMBIENT;
-        }
+    //if humidity too low, turn on humidifier, longer run if state LOW_2 || Emergency
+    if (humidifier) {
+        runHumidifier(humidity_ambient.getState() > 1);
     }
-}
 
-void readHSoil() {
-    //iterate over soil sensor arrays
-    for (int i = 0; i < HUMIDITY_SOIL_CNT; i++) {
-        servo_array[i].write(SERVO_CLOSED);
-
-        //lock handling
-        h_soil_current_millis[i] = millis();
-
-        unsigned long int lock_millis = lock_humidity_soil[i] * 60 * 1000;
-
-        if (h_soil_current_millis[i] - h_soil_last_millis[i] > lock_millis) {
+    if (sms) {
+        sms_status += SMS_HUMIDITY_AMBIENT;
+    }
 
-            h_soil_last_millis[i] = millis();
+    //lock handling
+    scheduler.schedule(readHAmbient, 0, timeMinutes(humidity_ambient.getLock()));
+}
 
-            //read humidity for each sensor
-            humidity_soil_array[i].readHumidity();
-            lock_humidity_soil[i] = humidity_soil_array[i].getLock();
-            uint8_t hum_sms = humidity_soil_array[i].getHumidifierSms();
+void readHSoil(uint8_t sensor) {
+    //read humidity of sensor
+    humidity_soil_array[sensor].readHumidity();
+    uint8_t hum_sms = humidity_soil_array[sensor].getHumidifierSms();
 
-            bool humidifier = hum_sms & 2;
-            bool sms = hum_sms & 1;
+    bool humidifier = hum_sms & 2;
+    bool sms = hum_sms & 1;
 
-            if (humidifier) {
-                //if humidity too low, open valve
-                servo_array[i].write(SERVO_OPEN);
-                run_soil_pump = true;
-            }
+    if (humidifier) {
+        //if humidity too low, open valve, it is closed when the pump stops
+        servo_array[sensor].write(SERVO_OPEN);
+        runSoilPump();
+    }
 
-            if (sms) {
-                sms_status += SMS_HUMIDITY_SOIL;
-            }
-        }
+    if (sms) {
+        sms_status += SMS_HUMIDITY_SOIL;
     }
+
+    //lock handling
+    scheduler.schedule(readHSoil, sensor, timeMinutes(humidity_soil_array[sensor].getLock()));
 }
 
 void loop() {
     sms_status = 0;
 
-    readTemperature();  
-    readHAmbient();
-    readHSoil();
+    //runs controllers and pump stops that are due, sleeps until the next one
+    scheduler.run();
 //
 //    if (sms_status > 0) {
 //        sendSms();
 //    }
 //
-    if (run_humidifier) {
-        runHumidifier();
-    }
-
-    if (run_soil_pump) {
-        runSoilPump();
-    }
 }
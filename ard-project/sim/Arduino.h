@@ -0,0 +1,62 @@
+#ifndef _ARDUINO_H
+#define _ARDUINO_H
+
+/**
+ * Host stand-in for the Arduino core, used by the simulation in this directory.
+ * Time is virtual (@see sim.h), millis() wraps at 2^32 like on the board.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+void digitalWrite(uint8_t pin, uint8_t value);
+
+int digitalRead(uint8_t pin);
+
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+
+unsigned long micros();
+
+void delay(unsigned long ms);
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+
+    template<typename T>
+    size_t print(T) {
+        return 0;
+    }
+
+    template<typename T>
+    size_t println(T) {
+        return 0;
+    }
+
+    size_t println() {
+        return 0;
+    }
+};
+
+extern HardwareSerial Serial;
+
+#endif
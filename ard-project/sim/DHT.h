@@ -0,0 +1,50 @@
+#ifndef _DHT_H
+#define _DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+
+//the library does not talk to the sensor more often than this, it returns the last values instead
+#define DHT_MIN_INTERVAL 2000
+
+/**
+ * Host stand-in for the Adafruit DHT library, values come from the model set by sim_dht_model().
+ * Like the library, one transaction reads both values and the result is cached in the object,
+ * so a copy of it has a cache of its own.
+ */
+class DHT {
+private:
+    uint8_t pin;
+    uint8_t type;
+    bool cached;
+    uint32_t last_read;
+    float temperature;
+    float humidity;
+
+public:
+    DHT(uint8_t pin, uint8_t type);
+
+    void begin();
+
+    /**
+     * Reads the sensor unless it was read less than DHT_MIN_INTERVAL ago
+     *
+     * @param force Read even if it was
+     * @return False if the read failed
+     */
+    bool read(bool force = false);
+
+    /**
+     * @return Temperature in degrees Celsius, NAN if the read fails
+     */
+    float readTemperature();
+
+    /**
+     * @return Relative humidity in percent, NAN if the read fails
+     */
+    float readHumidity();
+};
+
+#endif
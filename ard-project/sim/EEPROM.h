@@ -0,0 +1,29 @@
+#ifndef _EEPROM_H
+#define _EEPROM_H
+
+#include "Arduino.h"
+
+#define EEPROM_SIZE 4096
+
+/**
+ * Host stand-in for EEPROM, erased cells read 0xFF
+ */
+class EEPROMClass {
+private:
+    uint8_t cells[EEPROM_SIZE];
+
+public:
+    EEPROMClass();
+
+    uint8_t read(int address);
+
+    void write(int address, uint8_t value);
+
+    void update(int address, uint8_t value);
+
+    uint16_t length();
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _SERVO_H
+#define _SERVO_H
+
+#include "Arduino.h"
+
+/**
+ * Host stand-in for the Servo library, writes are recorded in the pin log (@see sim_log())
+ */
+class Servo {
+private:
+    int8_t pin;
+    int angle;
+
+public:
+    Servo();
+
+    uint8_t attach(int pin);
+
+    void detach();
+
+    void write(int angle);
+
+    int read();
+
+    bool attached();
+};
+
+#endif
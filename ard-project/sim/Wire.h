@@ -0,0 +1,16 @@
+#ifndef _WIRE_H
+#define _WIRE_H
+
+#include "Arduino.h"
+
+/**
+ * Host stand-in for the I2C library, nothing is connected
+ */
+class TwoWire {
+public:
+    void begin();
+};
+
+extern TwoWire Wire;
+
+#endif
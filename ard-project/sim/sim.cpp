@@ -0,0 +1,223 @@
+#include "Arduino.h"
+#include "DHT.h"
+#include "Servo.h"
+#include "EEPROM.h"
+#include "Wire.h"
+#include "sim.h"
+
+#include <string.h>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+TwoWire Wire;
+
+static uint32_t sim_millis = 0;
+static int pins[SIM_PINS];
+static int servos[SIM_PINS];
+static AnalogModel analog_models[SIM_PINS];
+static DhtModel dht_temperature = NULL;
+static DhtModel dht_humidity = NULL;
+static std::vector<SimWrite> writes;
+static unsigned long write_counts[2][SIM_PINS];
+static unsigned long dht_reads = 0;
+static unsigned long analog_reads = 0;
+
+//every write is counted, only changes are logged (the sketch rewrites pins on every pass)
+static void sim_record(uint8_t pin, int previous, int value, uint8_t kind) {
+    write_counts[kind][pin]++;
+    if (previous != value) {
+        SimWrite write = {sim_millis, pin, value, kind};
+        writes.push_back(write);
+    }
+}
+
+//simulation control
+
+void sim_reset(uint32_t start) {
+    sim_millis = start;
+    for (int i = 0; i < SIM_PINS; i++) {
+        pins[i] = LOW;
+        servos[i] = -1;
+        analog_models[i] = NULL;
+        write_counts[0][i] = 0;
+        write_counts[SIM_SERVO][i] = 0;
+    }
+    dht_temperature = NULL;
+    dht_humidity = NULL;
+    writes.clear();
+    dht_reads = 0;
+    analog_reads = 0;
+}
+
+void sim_advance(uint32_t ms) {
+    sim_millis += ms;
+}
+
+uint32_t sim_now() {
+    return sim_millis;
+}
+
+void sim_analog_model(uint8_t pin, AnalogModel model) {
+    analog_models[pin] = model;
+}
+
+void sim_dht_model(DhtModel temperature, DhtModel humidity) {
+    dht_temperature = temperature;
+    dht_humidity = humidity;
+}
+
+int sim_pin(uint8_t pin) {
+    return pins[pin];
+}
+
+int sim_servo(uint8_t pin) {
+    return servos[pin];
+}
+
+const std::vector<SimWrite> &sim_log() {
+    return writes;
+}
+
+unsigned long sim_writes(uint8_t pin, uint8_t kind) {
+    return write_counts[kind][pin];
+}
+
+unsigned long sim_dht_reads() {
+    return dht_reads;
+}
+
+unsigned long sim_analog_reads() {
+    return analog_reads;
+}
+
+//Arduino core
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    int previous = pins[pin];
+    pins[pin] = value ? HIGH : LOW;
+    sim_record(pin, previous, pins[pin], 0);
+}
+
+int digitalRead(uint8_t pin) {
+    return pins[pin];
+}
+
+int analogRead(uint8_t pin) {
+    analog_reads++;
+    return analog_models[pin] != NULL ? analog_models[pin](sim_millis) : 0;
+}
+
+unsigned long millis() {
+    return sim_millis;
+}
+
+unsigned long micros() {
+    return (unsigned long) (uint32_t) (sim_millis * 1000u);
+}
+
+void delay(unsigned long ms) {
+    sim_millis += (uint32_t) ms;
+}
+
+void HardwareSerial::begin(unsigned long) {
+}
+
+//DHT
+
+DHT::DHT(uint8_t pin, uint8_t type) {
+    this->pin = pin;
+    this->type = type;
+    this->cached = false;
+    this->last_read = 0;
+    this->temperature = NAN;
+    this->humidity = NAN;
+}
+
+void DHT::begin() {
+}
+
+bool DHT::read(bool force) {
+    if (!force && this->cached && sim_millis - this->last_read < DHT_MIN_INTERVAL) {
+        return !isnan(this->temperature) && !isnan(this->humidity);
+    }
+
+    dht_reads++;
+    this->cached = true;
+    this->last_read = sim_millis;
+    this->temperature = dht_temperature != NULL ? dht_temperature(sim_millis) : NAN;
+    this->humidity = dht_humidity != NULL ? dht_humidity(sim_millis) : NAN;
+    return !isnan(this->temperature) && !isnan(this->humidity);
+}
+
+float DHT::readTemperature() {
+    read();
+    return this->temperature;
+}
+
+float DHT::readHumidity() {
+    read();
+    return this->humidity;
+}
+
+//Servo
+
+Servo::Servo() {
+    this->pin = -1;
+    this->angle = 90;
+}
+
+uint8_t Servo::attach(int pin) {
+    this->pin = (int8_t) pin;
+    return 0;
+}
+
+void Servo::detach() {
+    this->pin = -1;
+}
+
+void Servo::write(int angle) {
+    this->angle = angle;
+    if (this->pin >= 0) {
+        int previous = servos[this->pin];
+        servos[this->pin] = angle;
+        sim_record((uint8_t) this->pin, previous, angle, SIM_SERVO);
+    }
+}
+
+int Servo::read() {
+    return this->angle;
+}
+
+bool Servo::attached() {
+    return this->pin >= 0;
+}
+
+//EEPROM
+
+EEPROMClass::EEPROMClass() {
+    memset(this->cells, 0xFF, sizeof(this->cells));
+}
+
+uint8_t EEPROMClass::read(int address) {
+    return this->cells[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    this->cells[address] = value;
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+    this->cells[address] = value;
+}
+
+uint16_t EEPROMClass::length() {
+    return EEPROM_SIZE;
+}
+
+//Wire
+
+void TwoWire::begin() {
+}
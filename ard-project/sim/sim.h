@@ -0,0 +1,93 @@
+#ifndef _SIM_H
+#define _SIM_H
+
+/**
+ * Control side of the host simulation.
+ *
+ * The sketch sees a virtual clock that only moves when the test moves it,
+ * sensors are functions of that clock and every change of a pin or servo is logged
+ * with its time, so tests can run days of uptime in a fraction of a second.
+ */
+
+#include <vector>
+
+#include "Arduino.h"
+
+#define SIM_PINS 70
+#define SIM_SERVO 1
+
+struct SimWrite {
+    uint32_t time;
+    uint8_t pin;
+    int value;
+    uint8_t kind;   //0 = digitalWrite, SIM_SERVO = Servo::write
+};
+
+//sensor models, now = virtual millis()
+typedef int (*AnalogModel)(uint32_t now);
+typedef float (*DhtModel)(uint32_t now);
+
+/**
+ * Clears the log, pins, models and counters, sets the clock to start
+ *
+ * @param start Initial millis()
+ */
+void sim_reset(uint32_t start = 0);
+
+/**
+ * @param ms Milliseconds to move the clock by (wraps at 2^32)
+ */
+void sim_advance(uint32_t ms);
+
+/**
+ * @return Current millis()
+ */
+uint32_t sim_now();
+
+/**
+ * @param pin Analog pin
+ * @param model Value returned by analogRead(pin), NULL = 0
+ */
+void sim_analog_model(uint8_t pin, AnalogModel model);
+
+/**
+ * @param temperature Value returned by DHT::readTemperature(), NULL = NAN
+ * @param humidity Value returned by DHT::readHumidity(), NULL = NAN
+ */
+void sim_dht_model(DhtModel temperature, DhtModel humidity);
+
+/**
+ * @param pin Digital pin
+ * @return Last value written to pin
+ */
+int sim_pin(uint8_t pin);
+
+/**
+ * @param pin Pin of the servo
+ * @return Last angle written to the servo, -1 if none
+ */
+int sim_servo(uint8_t pin);
+
+/**
+ * @return Every write that changed a pin or servo since sim_reset(), in order
+ */
+const std::vector<SimWrite> &sim_log();
+
+/**
+ * @param pin Pin
+ * @param kind 0 = digitalWrite, SIM_SERVO = Servo::write
+ * @return Number of writes to pin, changing or not
+ */
+unsigned long sim_writes(uint8_t pin, uint8_t kind = 0);
+
+/**
+ * @return Number of DHT transactions since sim_reset(), reads served from the cache of a DHT object do not count
+ */
+unsigned long sim_dht_reads();
+
+/**
+ * @return Number of analogRead() calls since sim_reset()
+ */
+unsigned long sim_analog_reads();
+
+#endif
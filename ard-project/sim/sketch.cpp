@@ -0,0 +1,2 @@
+//the sketch is built as an ordinary translation unit against the stand-in headers
+#include "../main/main.ino"
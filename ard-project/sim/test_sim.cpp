@@ -0,0 +1,389 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "AmbientSensor.h"
+#include "HumidityAmbient.h"
+#include "HumiditySoil.h"
+#include "Scheduler.h"
+#include "Temperature.h"
+#include "Timing.h"
+#include "sim.h"
+
+#define MINUTE 60000UL
+
+//sketch pins, @see main.ino
+#define MAIN_HEAT_PIN 8
+#define BACKUP_HEAT_PIN 9
+#define SOIL_SENSOR_PIN_0 0
+#define SOIL_SENSOR_PIN_1 1
+#define SERVO_PIN_0 6
+#define SERVO_PIN_1 7
+#define SOIL_PUMP_PIN_1 4
+#define PUMP_PIN_1 2
+#define HUMIDIFIER_DURATION 10000
+#define SOIL_PUMP_DURATION 15000
+
+void setup();
+
+void loop();
+
+extern Scheduler scheduler;
+
+//runs loop() until ms passed, loop() sleeps by moving the clock to the next deadline, return number of passes
+static unsigned long run(uint32_t ms) {
+    uint32_t end = timeNow() + ms;
+    unsigned long passes = 0;
+
+    while (!timeReached(end)) {
+        loop();
+        passes++;
+    }
+
+    return passes;
+}
+
+//runs test in a fresh copy of the sketch (its globals keep state), like a power cycle
+static void boot(void (*test)()) {
+    fflush(stdout);
+    pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+        test();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+//times of writes of value to pin, in order
+static std::vector<uint32_t> changes(uint8_t pin, int value, uint8_t kind = 0) {
+    std::vector<uint32_t> times;
+    const std::vector<SimWrite> &log = sim_log();
+
+    for (size_t i = 0; i < log.size(); i++) {
+        if (log[i].pin == pin && log[i].kind == kind && log[i].value == value) {
+            times.push_back(log[i].time);
+        }
+    }
+
+    return times;
+}
+
+static float cold(uint32_t) {
+    return 10;
+}
+
+static float comfortable(uint32_t) {
+    return 25;
+}
+
+static float humid(uint32_t) {
+    return 60;
+}
+
+static float dry_air(uint32_t) {
+    return 30;
+}
+
+//time the sketch booted at, models relative to it look the same wherever the clock starts
+static uint32_t boot_time = 0;
+
+//cold for the first 20 minutes of uptime
+static float cold_first(uint32_t now) {
+    return now - boot_time < 20 * MINUTE ? 10 : 25;
+}
+
+//cold for the first 2 hours of uptime
+static float cold_start(uint32_t now) {
+    return now - boot_time < 120 * MINUTE ? 10 : 25;
+}
+
+//dry air every other hour of uptime
+static float dry_hours(uint32_t now) {
+    return (now - boot_time) / (60 * MINUTE) % 2 == 0 ? 30 : 60;
+}
+
+//analogRead() of a dry soil sensor, humidity = 100 - 100 * value / 1023
+static int dry(uint32_t) {
+    return 1023;
+}
+
+static int wet(uint32_t) {
+    return 0;
+}
+
+//soil dries out after 3 hours of uptime, watering does not help
+static int drying(uint32_t now) {
+    return now - boot_time < 180 * MINUTE ? 0 : 1023;
+}
+
+//cold air, heat sources go on at the first read and stay on, backup state escalates to sms
+static void testTemperature() {
+    sim_reset();
+    sim_dht_model(cold, humid);
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    run(MINUTE);
+    assert(sim_pin(MAIN_HEAT_PIN) == LOW);
+    run(10);
+    assert(sim_pin(MAIN_HEAT_PIN) == HIGH);
+    assert(sim_pin(BACKUP_HEAT_PIN) == HIGH);
+
+    run(60 * MINUTE);
+    assert(sim_pin(MAIN_HEAT_PIN) == HIGH);
+    assert(sim_pin(BACKUP_HEAT_PIN) == HIGH);
+}
+
+//cold air warms up after 20 minutes, reads are at 1 (LOW_1, lock 15), 16 (LOW_2, lock 10) and 26 minutes,
+//backup heat goes off at the 26 minute read and main heat stays on (OK_MBS)
+static void testTemperatureRecovers() {
+    sim_reset();
+    sim_dht_model(cold_first, humid);
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    run(20 * MINUTE);
+    assert(sim_pin(MAIN_HEAT_PIN) == HIGH);
+    assert(sim_pin(BACKUP_HEAT_PIN) == HIGH);
+
+    run(20 * MINUTE);
+    std::vector<uint32_t> backup_on = changes(BACKUP_HEAT_PIN, HIGH);
+    std::vector<uint32_t> backup_off = changes(BACKUP_HEAT_PIN, LOW);
+    assert(backup_on.size() == 1 && backup_on[0] == MINUTE);
+    assert(backup_off.size() == 1 && backup_off[0] == 26 * MINUTE);
+    assert(changes(MAIN_HEAT_PIN, LOW).empty());
+    assert(sim_pin(MAIN_HEAT_PIN) == HIGH);
+    assert(sim_pin(BACKUP_HEAT_PIN) == LOW);
+}
+
+//dry soil on sensor 0, its valve opens with the soil pump and closes when the pump stops
+static void testSoil() {
+    sim_reset();
+    sim_dht_model(comfortable, humid);
+    sim_analog_model(SOIL_SENSOR_PIN_0, dry);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    run(60 * MINUTE + SOIL_PUMP_DURATION + 10);
+
+    std::vector<uint32_t> opened = changes(SERVO_PIN_0, 180, SIM_SERVO);
+    std::vector<uint32_t> closed = changes(SERVO_PIN_0, 0, SIM_SERVO);
+    std::vector<uint32_t> pump_on = changes(SOIL_PUMP_PIN_1, HIGH);
+    std::vector<uint32_t> pump_off = changes(SOIL_PUMP_PIN_1, LOW);
+    assert(opened.size() == 1 && pump_on.size() == 1 && pump_off.size() == 1);
+    assert(opened[0] == 60 * MINUTE && pump_on[0] == opened[0]);
+    assert(pump_off[0] == pump_on[0] + SOIL_PUMP_DURATION && closed.back() == pump_off[0]);
+    assert(changes(SERVO_PIN_1, 180, SIM_SERVO).empty());
+}
+
+//dry air, the humidifier runs for its duration, twice as long from LOW_2 on
+static void testHumidifier() {
+    sim_reset();
+    sim_dht_model(comfortable, dry_air);
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    run(25 * MINUTE);
+
+    std::vector<uint32_t> on = changes(PUMP_PIN_1, HIGH);
+    std::vector<uint32_t> off = changes(PUMP_PIN_1, LOW);
+    assert(on.size() == 2 && off.size() == 2);
+    assert(on[0] == 5 * MINUTE && off[0] == on[0] + HUMIDIFIER_DURATION);
+    assert(on[1] == 20 * MINUTE && off[1] == on[1] + 2 * HUMIDIFIER_DURATION);
+}
+
+//a day of uptime wakes the CPU only for deadlines
+static void testIdle() {
+    sim_reset();
+    sim_dht_model(comfortable, humid);
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    unsigned long passes = run(24 * 60 * MINUTE);
+    printf("1 day: %lu loop() passes, %lu DHT reads, idle %.4f %%\n", passes, sim_dht_reads(),
+           100.0 * scheduler.getIdleMillis() / sim_now());
+    assert(passes < 2000);
+}
+
+//soil that stays dry escalates to the sms state and returns to O once watered
+static void testSoilEscalates() {
+    sim_reset();
+    sim_analog_model(SOIL_SENSOR_PIN_0, dry);
+    HumiditySoil soil(50, SOIL_SENSOR_PIN_0);
+
+    soil.readHumidity();
+    assert(soil.getHumidifierSms() == 2 && soil.getLock() == 30);
+    soil.readHumidity();
+    assert(soil.getHumidifierSms() == 2);
+    soil.readHumidity();
+    assert(soil.getHumidifierSms() == 3);
+    soil.readHumidity();
+    assert(soil.getHumidifierSms() == 3);
+
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    soil.readHumidity();
+    assert(soil.getHumidifierSms() == 0 && soil.getLock() == 60);
+}
+
+//one DHT transaction per sampling period, shared by temperature and humidity
+static void testAmbientSensor() {
+    sim_reset();
+    sim_dht_model(cold, humid);
+    DHT dht(27, DHT11);
+    AmbientSensor sensor(dht, 5000);
+
+    const AmbientSample &sample = sensor.sample();
+    assert(sample.temperature == 10 && sample.humidity == 60 && sample.time == 0);
+    assert(sim_dht_reads() == 1);
+
+    sim_advance(4999);
+    sensor.sample();
+    assert(sim_dht_reads() == 1);
+
+    sim_advance(1);
+    sim_dht_model(comfortable, NULL);
+    assert(sensor.sample().temperature == 25 && isnan(sensor.sample().humidity));
+    assert(sensor.sample().time == 5000 && sim_dht_reads() == 2 && sensor.getFailures() == 1);
+}
+
+//failed reads are reported, the state stays and the controller asks again soon
+static void testSensorFailure() {
+    Temperature temperature(35, 20, 8, 9);
+    HumidityAmbient humidity(70, 50);
+    AmbientSample sample = {10, 30, 0};
+    assert(temperature.readTemperature(sample) && temperature.getMainBackupSms() == 6);
+    assert(humidity.readHumidity(sample) && humidity.getHumidifierSms() == 2);
+
+    sample.temperature = NAN;
+    sample.humidity = NAN;
+    assert(!temperature.readTemperature(sample) && temperature.getMainBackupSms() == 6 && temperature.getLock() == 1);
+    assert(!humidity.readHumidity(sample) && humidity.getHumidifierSms() == 2 && humidity.getLock() == 5);
+    assert(humidity.getState() == 1);
+
+    //sketch without a working sensor, nothing is switched on
+    sim_reset();
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+    run(60 * MINUTE + 1);
+    assert(changes(MAIN_HEAT_PIN, HIGH).empty() && changes(PUMP_PIN_1, HIGH).empty());
+    assert(sim_dht_reads() == 60);
+}
+
+//controllers due at the same time share one DHT transaction
+static void testSharedSample() {
+    sim_reset();
+    sim_dht_model(comfortable, humid);
+    sim_analog_model(SOIL_SENSOR_PIN_0, wet);
+    sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+    setup();
+
+    //temperature every minute, ambient humidity every 5 minutes
+    run(60 * MINUTE + 1);
+    assert(sim_dht_reads() == 60);
+}
+
+//helpers of Timing.h across the 2^32 wraparound of millis()
+static void testTiming() {
+    sim_reset(0xFFFFFF00u);
+    uint32_t start = timeNow();
+    uint32_t deadline = start + 0x200;
+    assert(deadline == 0x100);
+    assert(timeBefore(start, deadline) && !timeBefore(deadline, start));
+    assert(!timeReached(deadline) && timeUntil(deadline) == 0x200);
+
+    sim_advance(0x1FF);
+    assert(timeNow() == 0xFF && timeElapsed(start) == 0x1FF);
+    assert(!timeReached(deadline) && timeUntil(deadline) == 1);
+
+    sim_advance(1);
+    assert(timeReached(deadline) && timeUntil(deadline) == 0);
+    assert(timeMinutes(60) == 3600000u && timeMinutes(255) == 15300000u);
+}
+
+//every pin and servo change of a sketch booted at start, times relative to start
+static std::vector<SimWrite> trace(uint32_t start, uint32_t ms) {
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    fflush(stdout);
+    pid_t pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+        close(fds[0]);
+        sim_reset(start);
+        boot_time = start;
+        sim_dht_model(cold_start, dry_hours);
+        sim_analog_model(SOIL_SENSOR_PIN_0, drying);
+        sim_analog_model(SOIL_SENSOR_PIN_1, wet);
+        setup();
+        run(ms);
+
+        std::vector<SimWrite> log = sim_log();
+        for (size_t i = 0; i < log.size(); i++) {
+            log[i].time -= start;
+        }
+        size_t bytes = log.size() * sizeof(SimWrite);
+        ssize_t written = write(fds[1], log.data(), bytes);
+        assert(written == (ssize_t) bytes);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::vector<SimWrite> log;
+    SimWrite write;
+    while (read(fds[0], &write, sizeof(write)) == (ssize_t) sizeof(write)) {
+        log.push_back(write);
+    }
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return log;
+}
+
+//a sketch booted 49.7 days into uptime, 3 hours before millis() wraps, behaves as one booted at 0
+static void testWraparound() {
+    uint32_t ms = 8 * 60 * MINUTE;
+    std::vector<SimWrite> fresh = trace(0, ms);
+    std::vector<SimWrite> wrapped = trace((uint32_t) (0 - 3 * 60 * MINUTE), ms);
+
+    assert(fresh.size() > 20 && fresh.size() == wrapped.size());
+    for (size_t i = 0; i < fresh.size(); i++) {
+        assert(fresh[i].time == wrapped[i].time && fresh[i].pin == wrapped[i].pin);
+        assert(fresh[i].value == wrapped[i].value && fresh[i].kind == wrapped[i].kind);
+    }
+    printf("wraparound: %zu changes in 8 h match\n", fresh.size());
+}
+
+int main() {
+    boot(testTemperature);
+    boot(testTemperatureRecovers);
+    boot(testSoil);
+    boot(testHumidifier);
+    boot(testIdle);
+    boot(testSoilEscalates);
+    boot(testTiming);
+    boot(testAmbientSensor);
+    boot(testSensorFailure);
+    boot(testSharedSample);
+    testWraparound();
+
+    printf("OK\n");
+    return 0;
+}
@@ -43,11 +43,189 @@
       > Pozdejsi: Oct 10 15:40, 1x [289]
       > Predchazejici: Oct 10 15:40, 1x [289]
       > Pozdejsi: N/A
+
+  build:
+    gcc -O2 -pthread registration_plate_records.c -lm
+      -pthread is needed by --convoy and --shards, -lm by --rollup and --generate (log(), pow()),
+      the program links only with both whatever mode is used
+
+  modes (first program argument, input of cameras stays the same):
+    --trajectory:
+      query format: ([\S]+) ([a-zA-Z]{3} [0-9]{1,2} [0-9]{1,2}:[0-9]{1,2}) ([a-zA-Z]{3} [0-9]{1,2} [0-9]{1,2}:[0-9]{1,2})
+        $1 = registration plate
+        $2, $3 = time window (inclusive)
+
+      output for each query:
+        > Trasa:                         #followed by one line per camera passed, ordered by time
+          %b %d %H:%M, $x [$y]           #repeated hits at the same gate are collapsed into one line
+        > Trasa: N/A                     #plate was not seen in the time window
+
+      ex. input 3 (--trajectory):
+        { 1: A Mar 7 21:32, 1: A Mar 7 21:35, 2: A Mar 7 21:40, 1: A Mar 7 22:00, 3: A Mar 8 8:00 }
+        A Mar 7 21:00 Mar 7 23:00
+
+      ex. output 3:
+        Data z kamer:
+        Hledani:
+        > Trasa:
+          Mar 7 21:32, 2x [1]
+          Mar 7 21:40, 1x [2]
+          Mar 7 22:00, 1x [1]
+
+    --fuzzy:
+      query format: ([\S]+) ([0-2])
+        $1 = registration plate (as read by OCR, may contain errors)
+        $2 = maximal edit distance (Levenshtein) of returned plates
+
+      output for each query:
+        > Podobne:                       #followed by one line per known plate, closest first
+          $plate ($d), $x                #$d = edit distance to queried plate, $x = how many times the plate was seen
+
+      ex. input 4 (--fuzzy):
+        {10: ABC-12-34 Oct 1 7:30, 11: A8C-12-34 Oct 1 7:45, 289: XYZ-98-76 Oct 10 15:40}
+        ABC-12-34 1
+
+      ex. output 4:
+        Data z kamer:
+        Hledani:
+        > Podobne:
+          ABC-12-34 (0), 1x
+          A8C-12-34 (1), 1x
+
+    --convoy (build with -pthread):
+      query format: ([\S]+) ([0-9]+)
+        $1 = registration plate
+        $2 = time difference in minutes
+
+      output for each query:
+        > Spolujizda:                    #followed by up to 10 plates most often seen near the queried plate
+          $plate, $x                     #$x = how many sightings of the queried plate had $plate at the same camera
+                                         #     within the time difference
+        > Spolujizda: N/A                #no other plate was seen near the queried plate
+
+      ex. input 5 (--convoy):
+        {1: A Mar 7 21:32, 1: B Mar 7 21:33, 2: A Mar 7 21:50, 2: B Mar 7 21:52, 2: C Mar 7 21:51, 3: C Mar 7 23:00}
+        A 5
+
+      ex. output 5:
+        Data z kamer:
+        Hledani:
+        > Spolujizda:
+          B, 2x
+          C, 1x
+
+    --search:
+      query format: ([\S]+)
+        $1 = plate pattern, '*' matches any sequence of chars (also empty), '?' matches exactly one char
+
+      output for each query:
+        > Nalezeno:                      #followed by one line per matching plate, alphabetically
+          $plate, $x                     #$x = how many times the plate was seen
+
+      ex. input 7 (--search):
+        {10: ABC-12-34 Oct 1 7:30, 11: ABC-19-00 Oct 1 7:45, 12: ABD-12-34 Oct 2 8:00, 289: XYZ-98-76 Oct 10 15:40}
+        ABC-1*
+        AB?-12-34
+
+      ex. output 7:
+        Data z kamer:
+        Hledani:
+        > Nalezeno:
+          ABC-12-34, 1x
+          ABC-19-00, 1x
+        > Nalezeno:
+          ABC-12-34, 1x
+          ABD-12-34, 1x
+
+    --rollup (build with -lm):
+      query format: ([0-9]+) ([a-zA-Z]{3} [0-9]{1,2} [0-9]{1,2}:[0-9]{1,2}) ([a-zA-Z]{3} [0-9]{1,2} [0-9]{1,2}:[0-9]{1,2})
+        $1 = camera id
+        $2, $3 = first and last day (inclusive), times are ignored, whole days are counted,
+                 first day after last day = window over New Year (ex. Dec 30 - Jan 2)
+
+      output for each query:
+        > Provoz:                        #followed by one line per hour of day with any traffic in the days
+          %H:00, $x, ~$d                 #$x = sightings in that hour summed over the days,
+                                         #$d = estimated number of distinct plates (HyperLogLog, ~13% error)
+        > Provoz: N/A                    #camera saw nothing in the days
+        > Kamera nenalezena.             #camera saw nothing at all
+
+      ex. input 8 (--rollup):
+        {1: A Mar 7 21:32, 1: B Mar 7 21:33, 1: A Mar 8 21:50, 2: C Mar 7 8:00}
+        1 Mar 1 0:00 Mar 31 0:00
+
+      ex. output 8:
+        Data z kamer:
+        Hledani:
+        > Provoz:
+          21:00, 3x, ~2
+
+    --generate sightings [plates] [skew] [cameras] [queries] [seed]:
+      prints random input for the default mode (camera data followed by queries) instead of reading any
+        plates = number of distinct plates (default sightings / 10), skew = Zipf exponent of plate popularity
+        (default 1, 0 = uniform), cameras = number of cameras (default 100), queries = number of queries (default 1000)
+
+    --bench:
+      same as the default mode, prints number of records, ingest time (and MB/s if stdin is a file), sort time,
+      peak RSS and query latency percentiles to stderr
+
+      ex. scaling run:
+        for n in 10000 100000 1000000 10000000; do
+          ./a.out --generate $n > input.txt && ./a.out --bench < input.txt > /dev/null
+        done
+
+    --shards [N] (N = 1-64, build with -pthread):
+      same input, queries and output as the default mode
+      input is split into N chunks at ',' and parsed on N threads, records are routed by plate hash into N shards,
+      each shard is sorted by plate on its own thread, a query binary searches the shard owning its plate
+      and only looks at the sightings of that plate
+      N defaults to the number of CPUs
+
+    --retention N (N = 1-365):
+      keeps only sightings of the last N days (counted from the newest sighting), stored in per-day segments
+      queries and output are the same as --trajectory
+
+      ex. input 6 (--retention 2):
+        { 1: A Mar 5 10:00, 2: A Mar 6 10:00, 3: A Mar 7 10:00 }
+        A Mar 1 0:00 Mar 31 23:59
+
+      ex. output 6:
+        Data z kamer:
+        Hledani:
+        > Trasa:
+          Mar 6 10:00, 1x [2]
+          Mar 7 10:00, 1x [3]
+
+      dates have no year, a sighting more than half a year before the newest one is taken as the next year,
+      so days keep counting over New Year, query windows are taken in the year(s) closest to the newest sighting
+
+      ex. input 9 (--retention 3):
+        { 1: A Dec 29 10:00, 2: A Dec 30 10:00, 3: A Dec 31 23:50, 4: A Jan 1 0:10, 5: A Jan 2 8:00, 6: B Dec 31 12:00 }
+        A Dec 30 0:00 Jan 2 23:59
+        B Jan 1 0:00 Jan 31 23:59
+
+      ex. output 9:
+        Data z kamer:
+        Hledani:
+        > Trasa:
+          Dec 31 23:50, 1x [3]
+          Jan 1 00:10, 1x [4]
+          Jan 2 08:00, 1x [5]
+        > Trasa: N/A
 */
 
+//fmemopen(), sysconf(), clock_gettime() are POSIX, declare them also under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
 
 #define SIZE 1
 #define MONTH_ARR_LEN 12
@@ -58,6 +236,44 @@
 #define BEFORE -1
 #define VALIDATE_ERROR -1
 #define VALIDATE_SUCCESS 1
+#define MINUTES_PER_DAY (24 * 60)
+#define INDEX_SLOTS_INIT 64
+#define INDEX_SLOT_EMPTY -1
+#define FUZZY_MAX_DISTANCE 2
+#define FUZZY_INDEX_MAX_LEN 16
+#define FUZZY_VARIANTS_MAX 256
+#define RADIX_BITS 16
+#define MYERS_MAX_LEN 64
+#define REGISTRATION_MAX_LEN 1000
+#define CONVOY_TOP 10
+#define CONVOY_THREADS_MAX 16
+#define DAYS_PER_YEAR 365
+#define SEGMENT_EMPTY -1
+#define MINUTES_PER_YEAR (DAYS_PER_YEAR * MINUTES_PER_DAY)
+#define WILDCARD_ANY '*'
+#define WILDCARD_ONE '?'
+#define DICTIONARY_POSITIONS 16
+#define DICTIONARY_CHARS 256
+#define HOURS_PER_DAY 24
+#define HLL_BITS 6
+#define HLL_REGISTERS (1 << HLL_BITS)
+#define GENERATE_SEED 42
+#define GENERATE_PLATE_DIGITS 10000
+#define GENERATE_PLATES_MAX (26 * 26 * 26 * GENERATE_PLATE_DIGITS)
+#define SHARDS_MAX 64
+#define INPUT_CHUNK 65536
+#define POOL_BLOCK 65536
+
+#define MODE_DEFAULT 0
+#define MODE_TRAJECTORY 1
+#define MODE_FUZZY 2
+#define MODE_CONVOY 3
+#define MODE_RETENTION 4
+#define MODE_SEARCH 5
+#define MODE_ROLLUP 6
+#define MODE_GENERATE 7
+#define MODE_BENCH 8
+#define MODE_SHARDS 9
 
 typedef struct {
     int camera_id;
@@ -65,11 +281,302 @@ typedef struct {
     int month;
     int hour;
     int minute;
-    char registration[1001];
+    const char *registration;   //interned (@see platePoolAdd()) or the buffer given to recordRead()
 } RECORD;
 
+/*
+ * interned registration plates, each distinct plate is stored once and never moves
+ * strings are packed into blocks of POOL_BLOCK bytes, $slots is an open addressing hash table of them
+ */
+typedef struct {
+    char **blocks;
+    int blocks_cnt;
+    int blocks_size;
+    int block_used;
+    const char **slots;
+    int slots_size;
+    int strings_cnt;
+} PLATE_POOL;
+
+/*
+ * single sighting of a plate, time is stored as minutes since Jan 1 00:00 (@see getRecordMinutes())
+ */
+typedef struct {
+    int time;
+    int camera_id;
+} SIGHTING;
+
+/*
+ * all sightings of one registration plate, sorted by time (and camera_id) once $sorted is set
+ */
+typedef struct {
+    const char *registration;   //interned in the PLATE_POOL of the records, not owned
+    SIGHTING *sightings;
+    int sightings_cnt;
+    int sightings_size;
+    int sorted;
+} PLATE;
+
+/*
+ * per-plate sighting index
+ * $plates is dense (in order of first appearance), $slots is an open addressing hash table of indexes into $plates
+ */
+typedef struct {
+    PLATE *plates;
+    int plates_cnt;
+    int plates_size;
+    int *slots;
+    int slots_size;
+} PLATE_INDEX;
+
+/*
+ * hash of one deletion variant (plate with up to FUZZY_MAX_DISTANCE chars removed) and the plate it comes from
+ */
+typedef struct {
+    uint32_t hash;
+    int plate;
+} FUZZY_KEY;
+
+/*
+ * deletion-neighbourhood index over distinct plates of PLATE_INDEX
+ * two plates within edit distance k share a variant with at most k deletions on each side,
+ * so candidates are found by exact lookups of query variants and then verified by editDistance()
+ * plates longer than FUZZY_INDEX_MAX_LEN are not expanded, they are kept in $long_plates and verified one by one
+ */
+typedef struct {
+    FUZZY_KEY *keys;
+    int keys_cnt;
+    int *long_plates;
+    int long_plates_cnt;
+    int *visited;
+    int stamp;
+    PLATE_INDEX *index;
+} FUZZY_INDEX;
+
+/*
+ * pattern for bit-parallel edit distance (Myers/Hyyro), usable for patterns up to MYERS_MAX_LEN chars
+ * $peq[c] has bit i set if pattern[i] == c
+ */
+typedef struct {
+    const char *pattern;
+    int len;
+    uint64_t peq[256];
+} DISTANCE_PATTERN;
+
+/*
+ * single result of fuzzy lookup
+ */
+typedef struct {
+    int plate;
+    int distance;
+} FUZZY_MATCH;
+
+/*
+ * records of one camera, records_array[start, end) sorted by time (records_array is sorted by compareRecords())
+ */
+typedef struct {
+    int camera_id;
+    int start;
+    int end;
+} CAMERA_RUN;
+
+/*
+ * open addressing counter of partner plates, keyed by position in PLATE_INDEX
+ * $last_event keeps a partner from being counted twice around one sighting of the target
+ */
+typedef struct {
+    int *plates;
+    int *counts;
+    int *last_event;
+    int slots_size;
+    int used;
+} PARTNER_MAP;
+
+/*
+ * data shared by all convoy queries
+ * positions of records of plate p are plate_records[plate_start[p], plate_start[p + 1]), ordered like records_array
+ */
+typedef struct {
+    int *record_time;
+    int *record_plate;
+    int *plate_start;
+    int *plate_records;
+    CAMERA_RUN *runs;
+    int runs_cnt;
+    PLATE_INDEX *index;
+} CONVOY_DATA;
+
+/*
+ * work of one thread for one convoy query, the thread takes every $threads_cnt-th camera the target passed
+ * sightings of the target at camera g are target_records[groups[g], groups[g + 1])
+ */
+typedef struct {
+    CONVOY_DATA *data;
+    int target;
+    int delta;
+    int *target_records;
+    int *groups;
+    int groups_cnt;
+    int thread;
+    int threads_cnt;
+    PARTNER_MAP map;
+} CONVOY_JOB;
+
+typedef struct {
+    int plate;
+    int count;
+} CONVOY_PARTNER;
+
+/*
+ * trajectory being printed, consecutive sightings at the same gate are collapsed into $first (@see trajectoryAdd())
+ */
+typedef struct {
+    SIGHTING first;
+    int hits;
+    int printed;
+} TRAJECTORY;
+
+/*
+ * distinct plates of PLATE_INDEX sorted by registration, $plates are positions in $index
+ * char buckets: dictionary positions of plates with char c at position p (p < DICTIONARY_POSITIONS) are
+ * buckets[bucket_start[p * DICTIONARY_CHARS + c], bucket_start[p * DICTIONARY_CHARS + c + 1]), in ascending order
+ */
+typedef struct {
+    int *plates;
+    int plates_cnt;
+    PLATE_INDEX *index;
+    int *bucket_start;
+    int *buckets;
+} PLATE_DICTIONARY;
+
+typedef struct {
+    int plate;
+    SIGHTING sighting;
+} SEGMENT_SIGHTING;
+
+/*
+ * sightings of one day, in order of arrival
+ * registrations are stored in one pool (plate p is pool + plate_offsets[p]), $slots hash them to plates
+ * sightings of plate p sorted by time are plate_sightings[plate_start[p], plate_start[p + 1]),
+ * this per-plate index is built lazily and rebuilt if sightings were added since (@see segmentIndexed())
+ * every array is a single allocation, so a whole segment is dropped by a constant number of free() calls
+ */
+typedef struct {
+    int day;
+    SEGMENT_SIGHTING *sightings;
+    int sightings_cnt;
+    int sightings_size;
+    char *pool;
+    int pool_used;
+    int pool_size;
+    int *plate_offsets;
+    int plates_cnt;
+    int plates_size;
+    int *slots;
+    int slots_size;
+    int *plate_start;
+    SIGHTING *plate_sightings;
+    int indexed_cnt;
+} SEGMENT;
+
+/*
+ * ring of per-day segments, day d is stored in segments[d % retention_days]
+ * only days (newest_day - retention_days, newest_day] are kept, older sightings are dropped
+ * input has no year, days and times in the store count from Jan 1 of year 0 (@see segmentStoreTime()),
+ * so they keep growing over New Year, the first sighting is put in year 1
+ */
+typedef struct {
+    SEGMENT *segments;
+    int retention_days;
+    int newest_day;
+    int dropped_cnt;
+} SEGMENT_STORE;
+
+/*
+ * traffic of one camera in one hour: number of sightings and HyperLogLog sketch of distinct plates
+ */
+typedef struct {
+    int count;
+    unsigned char hll[HLL_REGISTERS];
+} ROLLUP_CELL;
+
+/*
+ * hourly cells of one camera, days[d] points to HOURS_PER_DAY cells of day d, NULL if the camera saw nothing that day
+ */
+typedef struct {
+    int camera_id;
+    ROLLUP_CELL *days[DAYS_PER_YEAR];
+} ROLLUP_CAMERA;
+
+/*
+ * camera x day x hour traffic cube, $slots is an open addressing hash table of camera ids to $cameras
+ */
+typedef struct {
+    ROLLUP_CAMERA **cameras;
+    int cameras_cnt;
+    int cameras_size;
+    int *slots;
+    int slots_size;
+} ROLLUP;
+
+/*
+ * growable array of records
+ */
+typedef struct {
+    RECORD *records;
+    int cnt;
+    int size;
+} RECORD_BUCKET;
+
+/*
+ * one chunk of input parsed by one thread, records are routed by plate hash into one bucket per shard
+ * $terminator is set to the offset just after '}' if the chunk contains the end of camera data
+ * registrations of the records are interned in the job's own $pool
+ */
+typedef struct {
+    char *input;
+    long start;
+    long end;
+    int shards_cnt;
+    PLATE_POOL pool;
+    RECORD_BUCKET buckets[SHARDS_MAX];
+    int failed;
+    long terminator;
+} SHARD_PARSE_JOB;
+
+/*
+ * merges buckets of one shard from all parse jobs (in input order) and sorts them
+ */
+typedef struct {
+    SHARD_PARSE_JOB *parse_jobs;
+    int parse_jobs_cnt;
+    int shard;
+    RECORD_BUCKET *records;
+} SHARD_MERGE_JOB;
+
 int size = SIZE;
 
+const char *platePoolAdd(PLATE_POOL *pool, const char *registration);
+
+/**
+ * realloc() wrapper, program exits if out of memory
+ *
+ * @param ptr
+ * @param new_size
+ * @return reallocated ptr
+ */
+void *memoryRealloc(void *ptr, size_t new_size) {
+    void *tmp_realloc = realloc(ptr, new_size);
+
+    if (tmp_realloc == NULL) {
+        free(ptr);
+        printf("Nedostatek pameti.\n");
+        exit(0);
+    }
+
+    return tmp_realloc;
+}
+
 void recordsPrint(RECORD record) {
     printf("camera_id[%d]; registration[%s]; month[%d]; day[%d]; hour[%d]; minute[%d]\n",
            record.camera_id, record.registration, record.month, record.day, record.hour, record.minute);
@@ -146,67 +653,97 @@ int validateRecord(RECORD record) {
     return VALIDATE_SUCCESS;
 }
 
+/**
+ * reads one record from $stream into $record, validates it
+ * the first record of input is preceded by '{', each record is followed by ',' or '}' (end of input) stored in $end
+ *
+ * @param stream stdin or a chunk of input (@see shardWorker())
+ * @param record
+ * @param registration buffer of REGISTRATION_MAX_LEN + 1 chars, $record->registration points to it
+ * @param first 1 if this is the first record of input
+ * @param end separator after the record
+ * @return VALIDATE_SUCCESS, VALIDATE_ERROR if the record is invalid (program exits)
+ */
+int recordRead(FILE *stream, RECORD *record, char *registration, int first, char *end) {
+    char pattern_check[2];
+    char month[MONTH_LEN + 1];   //one char more, "Mar5" must not be read as "Mar" and 5
+    int input;
+    int req;
+
+    //read input and store it into $record
+    if (first == 1) {
+        input = fscanf(stream, " %c %d : %1000s %4s %d %d : %d %c",
+                      &pattern_check[0],
+                      &record->camera_id,
+                      registration,
+                      month,
+                      &record->day,
+                      &record->hour,
+                      &record->minute,
+                      &pattern_check[1]);
+        req = 8;
+    } else {
+        //input pattern changes after the first input
+        input = fscanf(stream, "%d: %1000s %4s %d %d:%d %c",
+                      &record->camera_id,
+                      registration,
+                      month,
+                      &record->day,
+                      &record->hour,
+                      &record->minute,
+                      &pattern_check[1]);
+        req = 7;
+    }
+
+    if (input != req) {
+        return VALIDATE_ERROR;
+    }
+
+    record->registration = registration;
+    record->month = strlen(month) == MONTH_LEN - 1 ? getMonthToInt(month) : MONTH_ERR;
+
+    //basic input validation
+    if (record->month == MONTH_ERR || (first == 1 && pattern_check[0] != '{') ||
+        (pattern_check[1] != '}' && pattern_check[1] != ',') || validateRecord(*record) == VALIDATE_ERROR ||
+        strcmp(record->registration, "\0") == 0) {
+        return VALIDATE_ERROR;
+    }
+
+    *end = pattern_check[1];
+    return VALIDATE_SUCCESS;
+}
+
 /**
  * reads input and returns it as RECORD array, size of the array is stored in global variable $size
  *
+ * @param pool registrations of the records are interned here, the records are valid while it is
  * @return RECORD*
  */
-RECORD *recordsRead() {
-    RECORD *records = (RECORD *) malloc(size * sizeof(RECORD));
+RECORD *recordsRead(PLATE_POOL *pool) {
+    int capacity = size;
+    RECORD *records = (RECORD *) malloc(capacity * sizeof(RECORD));
     RECORD tmp;
-    char pattern_check[2];
-    int req = 8;
+    char registration[REGISTRATION_MAX_LEN + 1];
+    char end;
     int index = 0;
-    int first = 1;
-    int die = 0;
-    int input;
 
     //read until } is found
     while (1) {
-        if (first == 1 && index > 0) {
-            first = 0;
-        }
-        char month[4];
-        //read input and store it into a temporary variable
-        if (first == 1) {
-            input = scanf(" %c %d : %s %s %d %d : %d %c",
-                          &pattern_check[0],
-                          &tmp.camera_id,
-                          tmp.registration,
-                          month,
-                          &tmp.day,
-                          &tmp.hour,
-                          &tmp.minute,
-                          &pattern_check[1]);
-        } else {
-            //input pattern changes after the first input
-            input = scanf("%d: %s %s %d %d:%d %c",
-                          &tmp.camera_id,
-                          tmp.registration,
-                          month,
-                          &tmp.day,
-                          &tmp.hour,
-                          &tmp.minute,
-                          &pattern_check[1]);
-            req = 7;
-        }
-
-        tmp.month = getMonthToInt(month);
-        if (tmp.month == MONTH_ERR) {
-            die = 1;
-        }
+        int valid = recordRead(stdin, &tmp, registration, index == 0, &end);
 
-        //basic input validation
-        if ((first == 1 && pattern_check[0] != '{') || (pattern_check[1] != '}' && pattern_check[1] != ',')) {
-            die = 1;
+        //input is invalid ? exit
+        if (valid == VALIDATE_ERROR) {
+            printf("Nespravny vstup.\n");
+            free(records);
+            exit(0);
         }
 
-        //records array needs to be expanded
-        if (index >= size) {
+        //records array needs to be expanded, doubled so input of n records costs O(n) copies
+        if (index >= capacity) {
             RECORD *tmp_realloc;
 
-            size += 1;
-            tmp_realloc = (RECORD *) realloc(records, size * sizeof(RECORD));
+            capacity *= 2;
+            tmp_realloc = (RECORD *) realloc(records, capacity * sizeof(RECORD));
 
             //out of memory, program exits
             if (tmp_realloc == NULL) {
@@ -219,20 +756,13 @@ RECORD *recordsRead() {
         }
 
         //add values to array, return if end of input ( '}' )
+        tmp.registration = platePoolAdd(pool, registration);
         records[index] = tmp;
-
-
-        //input is invalid ? exit
-        if (input != req || die == 1 || validateRecord(records[index]) == VALIDATE_ERROR || strcmp(records[index].registration, "\0") == 0) {
-            printf("Nespravny vstup.\n");
-            free(records);
-            exit(0);
-        }
-
         index++;
 
         // } = end of input
-        if (pattern_check[1] == '}') {
+        if (end == '}') {
+            size = index;
             return records;
         }
     }
@@ -320,302 +850,3201 @@ int compareRecordsIgnoreId(const void *a, const void *b) {
 }
 
 /**
- * try to find $registration in $records_array, creates new $found_records array and returns it, size of $found_records is returned in $found_size
+ * number of days in a year before the first day of $month (1-12), February has 28 days (@see validateRecord())
  *
- * @param records_array array of records in which the desired registration number is being found
- * @param registration
- * @param found_size size of the newly created array
- * @return array of records with matching registration number
+ * @param month
+ * @return days before month
  */
-RECORD *getRecordsRegistration(RECORD *records_array, char *registration, int *found_size) {
-    int j = 0; //index in found_records array
-    RECORD *found_records = (RECORD *) malloc(*found_size * sizeof(RECORD));
+int getDaysBeforeMonth(int month) {
+    int days_before[MONTH_ARR_LEN] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
 
-    //iterate over records_array, if registrations are matching add it to found_records
-    for (int i = 0; i < size; ++i) {
-        if (strcmp(records_array[i].registration, registration) == 0) {
-            if (j >= *found_size) {
-                *found_size += 1;
-                RECORD *tmp_realloc = (RECORD *) realloc(found_records, *found_size * sizeof(RECORD));
+    return days_before[month - 1];
+}
 
-                if (tmp_realloc == NULL) {
-                    free(found_records);
-                    free(records_array);
-                    printf("Nedostatek pameti.\n");
-                    exit(0);
-                }
+/**
+ * returns time of $record as minutes since Jan 1 00:00, ordering matches compareRecordsIgnoreId()
+ *
+ * @param record
+ * @return minutes
+ */
+int getRecordMinutes(RECORD record) {
+    int day_of_year = getDaysBeforeMonth(record.month) + record.day - 1;
 
-                found_records = tmp_realloc;
-            }
+    return day_of_year * MINUTES_PER_DAY + record.hour * 60 + record.minute;
+}
 
-            found_records[j] = records_array[i];
-            j++;
-        }
-    }
+/**
+ * inverse of getRecordMinutes(), fills month, day, hour and minute of $record
+ *
+ * @param time minutes since Jan 1 00:00
+ * @param record
+ */
+void getMinutesToRecord(int time, RECORD *record) {
+    int day_of_year = time / MINUTES_PER_DAY;
 
-    return found_records;
+    record->month = MONTH_ARR_LEN;
+    while (record->month > 1 && getDaysBeforeMonth(record->month) > day_of_year) {
+        record->month--;
+    }
 
+    record->day = day_of_year - getDaysBeforeMonth(record->month) + 1;
+    record->hour = (time % MINUTES_PER_DAY) / 60;
+    record->minute = time % 60;
 }
 
 /**
- * returns all sightings of a registration number that is stored in $record_query
+ * prints time stored as minutes since Jan 1 00:00 in format %b %d %H:%M (without newline)
+ * times of later years (@see segmentStoreTime()) are printed as the day of their year
  *
- * cmp_val values:
- *      EXACT  => query == records_array[item]
- *      AFTER  => query >  records_array[item]
- *      BEFORE => query <  records_array[item]
- *
- * @param records_array
- * @param records_array_size
- * @param record_query
- * @param cnt
- * @param cmp_val
- * @return RECORD array and its size as cnt
+ * @param time
  */
-RECORD *getSightings(RECORD *records_array, int records_array_size, RECORD record_query, int *cnt, int cmp_val) {
+void printMinutes(int time) {
+    RECORD pseudo_record;
+    char month_print[4];
 
-    int res_size = 1;
-    int compare;
+    getMinutesToRecord(time % MINUTES_PER_YEAR, &pseudo_record);
+    getIntToMonth(pseudo_record.month, month_print);
+    printf("%s %d %02d:%02d", month_print, pseudo_record.day, pseudo_record.hour, pseudo_record.minute);
+}
 
-    RECORD *query_results = (RECORD *) malloc(res_size * sizeof(RECORD));
+/**
+ * FNV-1a hash of registration plate
+ *
+ * @param registration
+ * @return hash
+ */
+unsigned int hashRegistration(const char *registration) {
+    unsigned int hash = 2166136261u;
 
+    for (; *registration; ++registration) {
+        hash ^= (unsigned char) *registration;
+        hash *= 16777619u;
+    }
 
+    return hash;
+}
 
-    //iterate over records_array and look for matching registration numbers
-    for (int i = 0; i < records_array_size; ++i) {
-        record_query.camera_id = records_array[i].camera_id;
-        compare = compareRecords(&records_array[i], &record_query);
+void platePoolInit(PLATE_POOL *pool) {
+    pool->blocks_cnt = 0;
+    pool->blocks_size = SIZE;
+    pool->blocks = (char **) memoryRealloc(NULL, pool->blocks_size * sizeof(char *));
+    pool->block_used = POOL_BLOCK;
+    pool->strings_cnt = 0;
+    pool->slots_size = INDEX_SLOTS_INIT;
+    pool->slots = (const char **) memoryRealloc(NULL, pool->slots_size * sizeof(const char *));
 
-        if (compare == cmp_val) {
-            *cnt += 1;
+    for (int i = 0; i < pool->slots_size; ++i) {
+        pool->slots[i] = NULL;
+    }
+}
 
-            if ((*cnt - 1) >= res_size) {
-                res_size += 1;
-                RECORD *tmp = (RECORD *) realloc(query_results, res_size * sizeof(RECORD));
+/**
+ * frees all strings of $pool, freeing it again does nothing
+ *
+ * @param pool
+ */
+void platePoolFree(PLATE_POOL *pool) {
+    for (int i = 0; i < pool->blocks_cnt; ++i) {
+        free(pool->blocks[i]);
+    }
 
-                if (tmp == NULL) {
-                    free(records_array);
+    free(pool->blocks);
+    free(pool->slots);
+    pool->blocks = NULL;
+    pool->blocks_cnt = 0;
+    pool->slots = NULL;
+    pool->slots_size = 0;
+}
+
+/**
+ * returns slot of $registration in $pool->slots, the slot is NULL if the plate is not in the pool
+ *
+ * @param pool
+ * @param registration
+ * @return slot position
+ */
+int platePoolSlot(PLATE_POOL *pool, const char *registration) {
+    int mask = pool->slots_size - 1;
+    int slot = (int) (hashRegistration(registration) & (unsigned int) mask);
+
+    while (pool->slots[slot] != NULL && strcmp(pool->slots[slot], registration) != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * returns the interned copy of $registration, it is valid until platePoolFree()
+ *
+ * @param pool
+ * @param registration at most REGISTRATION_MAX_LEN chars
+ * @return const char*
+ */
+const char *platePoolAdd(PLATE_POOL *pool, const char *registration) {
+    int slot = platePoolSlot(pool, registration);
+
+    if (pool->slots[slot] != NULL) {
+        return pool->slots[slot];
+    }
+
+    int len = (int) strlen(registration) + 1;
+
+    if (pool->block_used + len > POOL_BLOCK) {
+        if (pool->blocks_cnt >= pool->blocks_size) {
+            pool->blocks_size *= 2;
+            pool->blocks = (char **) memoryRealloc(pool->blocks, pool->blocks_size * sizeof(char *));
+        }
+
+        pool->blocks[pool->blocks_cnt++] = (char *) memoryRealloc(NULL, POOL_BLOCK);
+        pool->block_used = 0;
+    }
+
+    char *copy = pool->blocks[pool->blocks_cnt - 1] + pool->block_used;
+    memcpy(copy, registration, len);
+    pool->block_used += len;
+    pool->slots[slot] = copy;
+    pool->strings_cnt++;
+
+    //keep load factor at most 1/2
+    if (pool->strings_cnt * 2 > pool->slots_size) {
+        const char **old_slots = pool->slots;
+        int old_size = pool->slots_size;
+
+        pool->slots_size *= 2;
+        pool->slots = (const char **) memoryRealloc(NULL, pool->slots_size * sizeof(const char *));
+        for (int i = 0; i < pool->slots_size; ++i) {
+            pool->slots[i] = NULL;
+        }
+        for (int i = 0; i < old_size; ++i) {
+            if (old_slots[i] != NULL) {
+                pool->slots[platePoolSlot(pool, old_slots[i])] = old_slots[i];
+            }
+        }
+        free(old_slots);
+    }
+
+    return copy;
+}
+
+/**
+ * a.time > b.time => AFTER, a.time < b.time => BEFORE, same time is ordered by camera_id
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+int compareSightings(const void *a, const void *b) {
+    const SIGHTING *sig_a = (const SIGHTING *) a;
+    const SIGHTING *sig_b = (const SIGHTING *) b;
+
+    if (sig_a->time != sig_b->time) {
+        return sig_a->time > sig_b->time ? AFTER : BEFORE;
+    }
+
+    if (sig_a->camera_id != sig_b->camera_id) {
+        return sig_a->camera_id > sig_b->camera_id ? AFTER : BEFORE;
+    }
+
+    return EXACT;
+}
+
+/**
+ * creates an empty plate index
+ *
+ * @return PLATE_INDEX*
+ */
+PLATE_INDEX *plateIndexInit() {
+    PLATE_INDEX *index = (PLATE_INDEX *) memoryRealloc(NULL, sizeof(PLATE_INDEX));
+
+    index->plates_cnt = 0;
+    index->plates_size = INDEX_SLOTS_INIT / 2;
+    index->plates = (PLATE *) memoryRealloc(NULL, index->plates_size * sizeof(PLATE));
+    index->slots_size = INDEX_SLOTS_INIT;
+    index->slots = (int *) memoryRealloc(NULL, index->slots_size * sizeof(int));
+
+    for (int i = 0; i < index->slots_size; ++i) {
+        index->slots[i] = INDEX_SLOT_EMPTY;
+    }
+
+    return index;
+}
+
+/**
+ * frees $index and all of its plates, registrations belong to the PLATE_POOL of the records
+ *
+ * @param index
+ */
+void plateIndexFree(PLATE_INDEX *index) {
+    for (int i = 0; i < index->plates_cnt; ++i) {
+        free(index->plates[i].sightings);
+    }
+
+    free(index->plates);
+    free(index->slots);
+    free(index);
+}
+
+/**
+ * returns slot of $registration in $index->slots, the slot is INDEX_SLOT_EMPTY if the plate is not indexed
+ *
+ * @param index
+ * @param registration
+ * @return slot position
+ */
+int plateIndexSlot(PLATE_INDEX *index, const char *registration) {
+    int mask = index->slots_size - 1;
+    int slot = (int) (hashRegistration(registration) & (unsigned int) mask);
+
+    //linear probing, the table is never more than half full
+    while (index->slots[slot] != INDEX_SLOT_EMPTY &&
+           strcmp(index->plates[index->slots[slot]].registration, registration) != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * doubles the slot table of $index and rehashes all plates
+ *
+ * @param index
+ */
+void plateIndexGrow(PLATE_INDEX *index) {
+    free(index->slots);
+    index->slots_size *= 2;
+    index->slots = (int *) memoryRealloc(NULL, index->slots_size * sizeof(int));
+
+    for (int i = 0; i < index->slots_size; ++i) {
+        index->slots[i] = INDEX_SLOT_EMPTY;
+    }
+
+    for (int i = 0; i < index->plates_cnt; ++i) {
+        index->slots[plateIndexSlot(index, index->plates[i].registration)] = i;
+    }
+}
+
+/**
+ * returns plate with $registration, NULL if it was never seen
+ *
+ * @param index
+ * @param registration
+ * @return PLATE*
+ */
+PLATE *plateIndexFind(PLATE_INDEX *index, const char *registration) {
+    int plate = index->slots[plateIndexSlot(index, registration)];
+
+    return plate == INDEX_SLOT_EMPTY ? NULL : &index->plates[plate];
+}
+
+/**
+ * adds sighting from $record to $index, creates the plate if needed
+ * sightings may arrive in any order, the plate is sorted lazily by plateIndexSorted()
+ * the plate keeps $record->registration, which must outlive $index (it is interned in a PLATE_POOL)
+ *
+ * @param index
+ * @param record
+ * @return position of the plate in $index->plates
+ */
+int plateIndexAdd(PLATE_INDEX *index, RECORD *record) {
+    int slot = plateIndexSlot(index, record->registration);
+
+    if (index->slots[slot] == INDEX_SLOT_EMPTY) {
+        if (index->plates_cnt >= index->plates_size) {
+            index->plates_size *= 2;
+            index->plates = (PLATE *) memoryRealloc(index->plates, index->plates_size * sizeof(PLATE));
+        }
+
+        PLATE *plate = &index->plates[index->plates_cnt];
+        plate->registration = record->registration;
+        plate->sightings_cnt = 0;
+        plate->sightings_size = SIZE;
+        plate->sightings = (SIGHTING *) memoryRealloc(NULL, plate->sightings_size * sizeof(SIGHTING));
+        plate->sorted = 1;
+
+        index->slots[slot] = index->plates_cnt++;
+
+        //keep load factor at most 1/2
+        if (index->plates_cnt * 2 > index->slots_size) {
+            plateIndexGrow(index);
+            slot = plateIndexSlot(index, record->registration);
+        }
+    }
+
+    PLATE *plate = &index->plates[index->slots[slot]];
+
+    if (plate->sightings_cnt >= plate->sightings_size) {
+        plate->sightings_size *= 2;
+        plate->sightings = (SIGHTING *) memoryRealloc(plate->sightings, plate->sightings_size * sizeof(SIGHTING));
+    }
+
+    SIGHTING sighting = {getRecordMinutes(*record), record->camera_id};
+
+    if (plate->sightings_cnt > 0 && compareSightings(&plate->sightings[plate->sightings_cnt - 1], &sighting) == AFTER) {
+        plate->sorted = 0;
+    }
+
+    plate->sightings[plate->sightings_cnt++] = sighting;
+
+    return index->slots[slot];
+}
+
+/**
+ * builds plate index over $records_array
+ *
+ * @param records_array
+ * @param records_array_size
+ * @return PLATE_INDEX*
+ */
+PLATE_INDEX *plateIndexBuild(RECORD *records_array, int records_array_size) {
+    PLATE_INDEX *index = plateIndexInit();
+
+    for (int i = 0; i < records_array_size; ++i) {
+        plateIndexAdd(index, &records_array[i]);
+    }
+
+    return index;
+}
+
+/**
+ * sorts sightings of $plate by time if they were not added in order
+ *
+ * @param plate
+ * @return PLATE* (same as $plate)
+ */
+PLATE *plateIndexSorted(PLATE *plate) {
+    if (!plate->sorted) {
+        qsort(plate->sightings, plate->sightings_cnt, sizeof(SIGHTING), compareSightings);
+        plate->sorted = 1;
+    }
+
+    return plate;
+}
+
+/**
+ * returns position of the first of time-sorted $sightings at or after $time, $sightings_cnt if there is none
+ *
+ * @param sightings
+ * @param sightings_cnt
+ * @param time minutes since Jan 1 00:00
+ * @return position in $sightings
+ */
+int sightingsLowerBound(SIGHTING *sightings, int sightings_cnt, int time) {
+    int low = 0;
+    int high = sightings_cnt;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (sightings[mid].time < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * prepares $pattern for editDistance(), the string must stay valid while the pattern is used
+ *
+ * @param pattern
+ * @param str
+ */
+void distancePatternInit(DISTANCE_PATTERN *pattern, const char *str) {
+    pattern->pattern = str;
+    pattern->len = (int) strlen(str);
+    memset(pattern->peq, 0, sizeof(pattern->peq));
+
+    if (pattern->len <= MYERS_MAX_LEN) {
+        for (int i = 0; i < pattern->len; ++i) {
+            pattern->peq[(unsigned char) str[i]] |= (uint64_t) 1 << i;
+        }
+    }
+}
+
+/**
+ * Levenshtein distance between $pattern and $text
+ * bit-parallel (one machine word per text char) if the pattern is short enough, classic two row DP otherwise
+ *
+ * @param pattern
+ * @param text
+ * @return edit distance
+ */
+int editDistance(DISTANCE_PATTERN *pattern, const char *text) {
+    int text_len = (int) strlen(text);
+
+    if (pattern->len == 0 || text_len == 0) {
+        return pattern->len + text_len;
+    }
+
+    if (pattern->len <= MYERS_MAX_LEN) {
+        uint64_t pv = ~(uint64_t) 0;
+        uint64_t mv = 0;
+        uint64_t last = (uint64_t) 1 << (pattern->len - 1);
+        int score = pattern->len;
+
+        for (int j = 0; j < text_len; ++j) {
+            uint64_t eq = pattern->peq[(unsigned char) text[j]];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            if (ph & last) {
+                score++;
+            } else if (mh & last) {
+                score--;
+            }
+
+            //first row of the DP matrix grows by one with every text char
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+
+        return score;
+    }
+
+    int row_a[REGISTRATION_MAX_LEN + 1], row_b[REGISTRATION_MAX_LEN + 1];
+    int *prev = row_a, *cur = row_b;
+
+    for (int i = 0; i <= pattern->len; ++i) {
+        prev[i] = i;
+    }
+
+    for (int j = 1; j <= text_len; ++j) {
+        cur[0] = j;
+        for (int i = 1; i <= pattern->len; ++i) {
+            int cost = prev[i - 1] + (pattern->pattern[i - 1] != text[j - 1]);
+            if (prev[i] + 1 < cost) {
+                cost = prev[i] + 1;
+            }
+            if (cur[i - 1] + 1 < cost) {
+                cost = cur[i - 1] + 1;
+            }
+            cur[i] = cost;
+        }
+
+        int *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+
+    return prev[pattern->len];
+}
+
+/**
+ * hashes of all variants of $str with up to $max_deletions chars removed (FNV-1a, @see hashRegistration())
+ * variants are not deduplicated, the buffer must hold 1 + len + len * (len - 1) / 2 hashes
+ *
+ * @param str
+ * @param len
+ * @param max_deletions 0 - 2
+ * @param hashes output buffer
+ * @return number of hashes written
+ */
+int deletionHashes(const char *str, int len, int max_deletions, uint32_t *hashes) {
+    int cnt = 0;
+
+    //skip_a/skip_b == len means nothing is skipped, skip_a < skip_b to avoid producing each variant twice
+    for (int skip_a = 0; skip_a <= len; ++skip_a) {
+        for (int skip_b = skip_a + 1; skip_b <= len + 1; ++skip_b) {
+            int deletions = (skip_a < len) + (skip_b < len);
+
+            if (deletions > max_deletions || (skip_b == len + 1 && skip_a != len)) {
+                continue;
+            }
+
+            uint32_t hash = 2166136261u;
+            for (int i = 0; i < len; ++i) {
+                if (i != skip_a && i != skip_b) {
+                    hash ^= (unsigned char) str[i];
+                    hash *= 16777619u;
+                }
+            }
+
+            hashes[cnt++] = hash;
+        }
+    }
+
+    return cnt;
+}
+
+/**
+ * stable LSD radix sort of $keys by hash, RADIX_BITS per pass
+ *
+ * @param keys
+ * @param keys_cnt
+ */
+void fuzzyKeysSort(FUZZY_KEY *keys, int keys_cnt) {
+    int buckets = 1 << RADIX_BITS;
+    int *counts = (int *) memoryRealloc(NULL, buckets * sizeof(int));
+    FUZZY_KEY *tmp = (FUZZY_KEY *) memoryRealloc(NULL, (keys_cnt + 1) * sizeof(FUZZY_KEY));
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        memset(counts, 0, buckets * sizeof(int));
+        for (int i = 0; i < keys_cnt; ++i) {
+            counts[(keys[i].hash >> shift) & (buckets - 1)]++;
+        }
+
+        //counts -> starting positions
+        int position = 0;
+        for (int i = 0; i < buckets; ++i) {
+            int cnt = counts[i];
+            counts[i] = position;
+            position += cnt;
+        }
+
+        for (int i = 0; i < keys_cnt; ++i) {
+            tmp[counts[(keys[i].hash >> shift) & (buckets - 1)]++] = keys[i];
+        }
+
+        memcpy(keys, tmp, keys_cnt * sizeof(FUZZY_KEY));
+    }
+
+    free(tmp);
+    free(counts);
+}
+
+/**
+ * builds deletion-neighbourhood index over distinct plates of $index, the index must not change while it is used
+ *
+ * @param index
+ * @return FUZZY_INDEX*
+ */
+FUZZY_INDEX *fuzzyIndexBuild(PLATE_INDEX *index) {
+    FUZZY_INDEX *fuzzy = (FUZZY_INDEX *) memoryRealloc(NULL, sizeof(FUZZY_INDEX));
+    uint32_t hashes[FUZZY_VARIANTS_MAX];
+    int keys_size = SIZE;
+
+    fuzzy->index = index;
+    fuzzy->keys_cnt = 0;
+    fuzzy->keys = (FUZZY_KEY *) memoryRealloc(NULL, keys_size * sizeof(FUZZY_KEY));
+    fuzzy->long_plates_cnt = 0;
+    fuzzy->long_plates = (int *) memoryRealloc(NULL, (index->plates_cnt + 1) * sizeof(int));
+    fuzzy->visited = (int *) memoryRealloc(NULL, (index->plates_cnt + 1) * sizeof(int));
+    fuzzy->stamp = 0;
+
+    for (int n = 0; n < index->plates_cnt; ++n) {
+        const char *registration = index->plates[n].registration;
+        int len = (int) strlen(registration);
+
+        fuzzy->visited[n] = 0;
+
+        if (len > FUZZY_INDEX_MAX_LEN) {
+            fuzzy->long_plates[fuzzy->long_plates_cnt++] = n;
+            continue;
+        }
+
+        int hashes_cnt = deletionHashes(registration, len, FUZZY_MAX_DISTANCE, hashes);
+
+        if (fuzzy->keys_cnt + hashes_cnt > keys_size) {
+            while (fuzzy->keys_cnt + hashes_cnt > keys_size) {
+                keys_size *= 2;
+            }
+            fuzzy->keys = (FUZZY_KEY *) memoryRealloc(fuzzy->keys, keys_size * sizeof(FUZZY_KEY));
+        }
+
+        for (int i = 0; i < hashes_cnt; ++i) {
+            fuzzy->keys[fuzzy->keys_cnt].hash = hashes[i];
+            fuzzy->keys[fuzzy->keys_cnt].plate = n;
+            fuzzy->keys_cnt++;
+        }
+    }
+
+    fuzzyKeysSort(fuzzy->keys, fuzzy->keys_cnt);
+
+    //drop repeated variants of the same plate ("AAB" minus either 'A'), they are adjacent after the stable sort
+    int unique = 0;
+    for (int i = 0; i < fuzzy->keys_cnt; ++i) {
+        if (unique == 0 || fuzzy->keys[unique - 1].hash != fuzzy->keys[i].hash ||
+            fuzzy->keys[unique - 1].plate != fuzzy->keys[i].plate) {
+            fuzzy->keys[unique++] = fuzzy->keys[i];
+        }
+    }
+    fuzzy->keys_cnt = unique;
+
+    return fuzzy;
+}
+
+void fuzzyIndexFree(FUZZY_INDEX *fuzzy) {
+    free(fuzzy->keys);
+    free(fuzzy->long_plates);
+    free(fuzzy->visited);
+    free(fuzzy);
+}
+
+//plate index used by comparators of plate results, qsort has no context argument
+PLATE_INDEX *sort_index = NULL;
+
+/**
+ * a.distance > b.distance => AFTER, a.distance < b.distance => BEFORE, same distance is ordered by registration
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+int compareFuzzyMatches(const void *a, const void *b) {
+    const FUZZY_MATCH *match_a = (const FUZZY_MATCH *) a;
+    const FUZZY_MATCH *match_b = (const FUZZY_MATCH *) b;
+
+    if (match_a->distance != match_b->distance) {
+        return match_a->distance > match_b->distance ? AFTER : BEFORE;
+    }
+
+    return strcmp(sort_index->plates[match_a->plate].registration,
+                  sort_index->plates[match_b->plate].registration);
+}
+
+/**
+ * verifies candidate $plate and adds it to $matches if it is within $max_distance edits of $pattern
+ * every plate is verified at most once per query (@see FUZZY_INDEX.stamp)
+ *
+ * @param fuzzy
+ * @param pattern queried registration
+ * @param plate candidate, position in PLATE_INDEX
+ * @param max_distance
+ * @param matches array of matches, grows as needed
+ * @param matches_cnt
+ * @param matches_size
+ */
+void fuzzyVerify(FUZZY_INDEX *fuzzy, DISTANCE_PATTERN *pattern, int plate, int max_distance,
+                 FUZZY_MATCH **matches, int *matches_cnt, int *matches_size) {
+    if (fuzzy->visited[plate] == fuzzy->stamp) {
+        return;
+    }
+    fuzzy->visited[plate] = fuzzy->stamp;
+
+    int distance = editDistance(pattern, fuzzy->index->plates[plate].registration);
+    if (distance > max_distance) {
+        return;
+    }
+
+    if (*matches_cnt >= *matches_size) {
+        *matches_size *= 2;
+        *matches = (FUZZY_MATCH *) memoryRealloc(*matches, *matches_size * sizeof(FUZZY_MATCH));
+    }
+
+    (*matches)[*matches_cnt].plate = plate;
+    (*matches)[*matches_cnt].distance = distance;
+    (*matches_cnt)++;
+}
+
+/**
+ * finds all plates within $max_distance edits of $registration
+ * looks up every variant of the query with up to $max_distance deletions, verifies only the plates found
+ *
+ * @param fuzzy
+ * @param registration
+ * @param max_distance 0 - FUZZY_MAX_DISTANCE
+ * @param matches_cnt number of returned matches
+ * @return FUZZY_MATCH array sorted by distance and registration, must be freed
+ */
+FUZZY_MATCH *fuzzyIndexFind(FUZZY_INDEX *fuzzy, const char *registration, int max_distance, int *matches_cnt) {
+    int matches_size = SIZE;
+    FUZZY_MATCH *matches = (FUZZY_MATCH *) memoryRealloc(NULL, matches_size * sizeof(FUZZY_MATCH));
+    DISTANCE_PATTERN pattern;
+    int len = (int) strlen(registration);
+
+    *matches_cnt = 0;
+    fuzzy->stamp++;
+    distancePatternInit(&pattern, registration);
+
+    //indexed plates are at most FUZZY_INDEX_MAX_LEN long, longer queries can't be within $max_distance of them
+    if (len <= FUZZY_INDEX_MAX_LEN + max_distance) {
+        uint32_t hashes[FUZZY_VARIANTS_MAX];
+        int hashes_cnt = deletionHashes(registration, len, max_distance, hashes);
+
+        for (int h = 0; h < hashes_cnt; ++h) {
+            //lower bound of the variant in sorted keys
+            int low = 0;
+            int high = fuzzy->keys_cnt;
+            while (low < high) {
+                int mid = low + (high - low) / 2;
+                if (fuzzy->keys[mid].hash < hashes[h]) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+
+            for (int i = low; i < fuzzy->keys_cnt && fuzzy->keys[i].hash == hashes[h]; ++i) {
+                fuzzyVerify(fuzzy, &pattern, fuzzy->keys[i].plate, max_distance, &matches, matches_cnt, &matches_size);
+            }
+        }
+    }
+
+    for (int i = 0; i < fuzzy->long_plates_cnt; ++i) {
+        fuzzyVerify(fuzzy, &pattern, fuzzy->long_plates[i], max_distance, &matches, matches_cnt, &matches_size);
+    }
+
+    sort_index = fuzzy->index;
+    qsort(matches, *matches_cnt, sizeof(FUZZY_MATCH), compareFuzzyMatches);
+
+    return matches;
+}
+
+/**
+ * initializes empty partner map
+ *
+ * @param map
+ */
+void partnerMapInit(PARTNER_MAP *map) {
+    map->slots_size = INDEX_SLOTS_INIT;
+    map->used = 0;
+    map->plates = (int *) memoryRealloc(NULL, map->slots_size * sizeof(int));
+    map->counts = (int *) memoryRealloc(NULL, map->slots_size * sizeof(int));
+    map->last_event = (int *) memoryRealloc(NULL, map->slots_size * sizeof(int));
+
+    for (int i = 0; i < map->slots_size; ++i) {
+        map->plates[i] = INDEX_SLOT_EMPTY;
+    }
+}
+
+void partnerMapFree(PARTNER_MAP *map) {
+    free(map->plates);
+    free(map->counts);
+    free(map->last_event);
+}
+
+/**
+ * returns slot of $plate in $map, the slot is INDEX_SLOT_EMPTY if the plate is not in the map
+ *
+ * @param map
+ * @param plate
+ * @return slot position
+ */
+int partnerMapSlot(PARTNER_MAP *map, int plate) {
+    int mask = map->slots_size - 1;
+    int slot = (int) (((unsigned int) plate * 2654435761u) & (unsigned int) mask);
+
+    while (map->plates[slot] != INDEX_SLOT_EMPTY && map->plates[slot] != plate) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * adds $count to $plate, if $event is not INDEX_SLOT_EMPTY the plate is counted at most once per event
+ *
+ * @param map
+ * @param plate
+ * @param event position of the target sighting, INDEX_SLOT_EMPTY if not applicable
+ * @param count
+ */
+void partnerMapAdd(PARTNER_MAP *map, int plate, int event, int count) {
+    int slot = partnerMapSlot(map, plate);
+
+    if (map->plates[slot] == plate) {
+        if (event != INDEX_SLOT_EMPTY && map->last_event[slot] == event) {
+            return;
+        }
+
+        map->counts[slot] += count;
+        map->last_event[slot] = event;
+        return;
+    }
+
+    map->plates[slot] = plate;
+    map->counts[slot] = count;
+    map->last_event[slot] = event;
+    map->used++;
+
+    //keep load factor at most 1/2
+    if (map->used * 2 > map->slots_size) {
+        PARTNER_MAP grown;
+        grown.slots_size = map->slots_size * 2;
+        grown.used = map->used;
+        grown.plates = (int *) memoryRealloc(NULL, grown.slots_size * sizeof(int));
+        grown.counts = (int *) memoryRealloc(NULL, grown.slots_size * sizeof(int));
+        grown.last_event = (int *) memoryRealloc(NULL, grown.slots_size * sizeof(int));
+
+        for (int i = 0; i < grown.slots_size; ++i) {
+            grown.plates[i] = INDEX_SLOT_EMPTY;
+        }
+
+        for (int i = 0; i < map->slots_size; ++i) {
+            if (map->plates[i] != INDEX_SLOT_EMPTY) {
+                int new_slot = partnerMapSlot(&grown, map->plates[i]);
+                grown.plates[new_slot] = map->plates[i];
+                grown.counts[new_slot] = map->counts[i];
+                grown.last_event[new_slot] = map->last_event[i];
+            }
+        }
+
+        partnerMapFree(map);
+        *map = grown;
+    }
+}
+
+/**
+ * builds data for convoy queries over $records_array sorted by compareRecords()
+ *
+ * @param records_array
+ * @param records_array_size
+ * @return CONVOY_DATA*
+ */
+CONVOY_DATA *convoyBuild(RECORD *records_array, int records_array_size) {
+    CONVOY_DATA *data = (CONVOY_DATA *) memoryRealloc(NULL, sizeof(CONVOY_DATA));
+
+    data->index = plateIndexInit();
+    data->record_time = (int *) memoryRealloc(NULL, (records_array_size + 1) * sizeof(int));
+    data->record_plate = (int *) memoryRealloc(NULL, (records_array_size + 1) * sizeof(int));
+    data->plate_records = (int *) memoryRealloc(NULL, (records_array_size + 1) * sizeof(int));
+    data->runs = (CAMERA_RUN *) memoryRealloc(NULL, (records_array_size + 1) * sizeof(CAMERA_RUN));
+    data->runs_cnt = 0;
+
+    for (int i = 0; i < records_array_size; ++i) {
+        data->record_plate[i] = plateIndexAdd(data->index, &records_array[i]);
+        data->record_time[i] = getRecordMinutes(records_array[i]);
+
+        if (data->runs_cnt == 0 || data->runs[data->runs_cnt - 1].camera_id != records_array[i].camera_id) {
+            data->runs[data->runs_cnt].camera_id = records_array[i].camera_id;
+            data->runs[data->runs_cnt].start = i;
+            data->runs_cnt++;
+        }
+        data->runs[data->runs_cnt - 1].end = i + 1;
+    }
+
+    //counting sort of record positions by plate, keeps camera and time order within each plate
+    int plates_cnt = data->index->plates_cnt;
+    data->plate_start = (int *) memoryRealloc(NULL, (plates_cnt + 1) * sizeof(int));
+    memset(data->plate_start, 0, (plates_cnt + 1) * sizeof(int));
+
+    for (int i = 0; i < records_array_size; ++i) {
+        data->plate_start[data->record_plate[i] + 1]++;
+    }
+    for (int p = 0; p < plates_cnt; ++p) {
+        data->plate_start[p + 1] += data->plate_start[p];
+    }
+
+    int *fill = (int *) memoryRealloc(NULL, (plates_cnt + 1) * sizeof(int));
+    memcpy(fill, data->plate_start, (plates_cnt + 1) * sizeof(int));
+    for (int i = 0; i < records_array_size; ++i) {
+        data->plate_records[fill[data->record_plate[i]]++] = i;
+    }
+    free(fill);
+
+    return data;
+}
+
+void convoyFree(CONVOY_DATA *data) {
+    plateIndexFree(data->index);
+    free(data->record_time);
+    free(data->record_plate);
+    free(data->plate_start);
+    free(data->plate_records);
+    free(data->runs);
+    free(data);
+}
+
+/**
+ * returns camera run containing record at $position
+ *
+ * @param data
+ * @param position
+ * @return CAMERA_RUN*
+ */
+CAMERA_RUN *convoyRun(CONVOY_DATA *data, int position) {
+    int low = 0;
+    int high = data->runs_cnt - 1;
+
+    while (low < high) {
+        int mid = low + (high - low + 1) / 2;
+
+        if (data->runs[mid].start <= position) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    return &data->runs[low];
+}
+
+/**
+ * thread body, sweeps a window of +-delta minutes along time-sorted sightings of each camera of the job
+ * and counts other plates seen in the window around each sighting of the target
+ *
+ * @param arg CONVOY_JOB*
+ * @return NULL
+ */
+void *convoyWorker(void *arg) {
+    CONVOY_JOB *job = (CONVOY_JOB *) arg;
+    CONVOY_DATA *data = job->data;
+
+    for (int g = job->thread; g < job->groups_cnt; g += job->threads_cnt) {
+        CAMERA_RUN *run = convoyRun(data, job->target_records[job->groups[g]]);
+        int low = run->start;
+        int high = run->start;
+
+        for (int t = job->groups[g]; t < job->groups[g + 1]; ++t) {
+            int event = job->target_records[t];
+            int time = data->record_time[event];
+
+            //both window borders only move forward, target sightings are sorted by time
+            while (low < run->end && data->record_time[low] < time - job->delta) {
+                low++;
+            }
+            if (high < low) {
+                high = low;
+            }
+            while (high < run->end && data->record_time[high] <= time + job->delta) {
+                high++;
+            }
+
+            for (int k = low; k < high; ++k) {
+                if (data->record_plate[k] != job->target) {
+                    partnerMapAdd(&job->map, data->record_plate[k], event, 1);
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * a.count > b.count => BEFORE, a.count < b.count => AFTER, same count is ordered by registration
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+int compareConvoyPartners(const void *a, const void *b) {
+    const CONVOY_PARTNER *partner_a = (const CONVOY_PARTNER *) a;
+    const CONVOY_PARTNER *partner_b = (const CONVOY_PARTNER *) b;
+
+    if (partner_a->count != partner_b->count) {
+        return partner_a->count > partner_b->count ? BEFORE : AFTER;
+    }
+
+    return strcmp(sort_index->plates[partner_a->plate].registration,
+                  sort_index->plates[partner_b->plate].registration);
+}
+
+/**
+ * counts plates seen at the same camera within $delta minutes of $target, cameras are processed on parallel threads
+ *
+ * @param data
+ * @param target position of the target plate in data->index
+ * @param delta minutes
+ * @param partners_cnt number of returned partners
+ * @return CONVOY_PARTNER array sorted by count (descending) and registration, must be freed
+ */
+CONVOY_PARTNER *convoyFind(CONVOY_DATA *data, int target, int delta, int *partners_cnt) {
+    int *target_records = &data->plate_records[data->plate_start[target]];
+    int target_cnt = data->plate_start[target + 1] - data->plate_start[target];
+
+    //split sightings of the target by camera
+    int *groups = (int *) memoryRealloc(NULL, (target_cnt + 1) * sizeof(int));
+    int groups_cnt = 0;
+    for (int t = 0; t < target_cnt; ++t) {
+        if (t == 0 || convoyRun(data, target_records[t]) != convoyRun(data, target_records[t - 1])) {
+            groups[groups_cnt++] = t;
+        }
+    }
+    groups[groups_cnt] = target_cnt;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads_cnt = cpus < 1 ? 1 : (cpus > CONVOY_THREADS_MAX ? CONVOY_THREADS_MAX : (int) cpus);
+    if (threads_cnt > groups_cnt) {
+        threads_cnt = groups_cnt;
+    }
+
+    CONVOY_JOB jobs[CONVOY_THREADS_MAX];
+    pthread_t threads[CONVOY_THREADS_MAX];
+    int started[CONVOY_THREADS_MAX];
+
+    for (int i = 0; i < threads_cnt; ++i) {
+        jobs[i].data = data;
+        jobs[i].target = target;
+        jobs[i].delta = delta;
+        jobs[i].target_records = target_records;
+        jobs[i].groups = groups;
+        jobs[i].groups_cnt = groups_cnt;
+        jobs[i].thread = i;
+        jobs[i].threads_cnt = threads_cnt;
+        partnerMapInit(&jobs[i].map);
+    }
+
+    //job 0 runs on the calling thread, so does every job whose thread can't be created
+    for (int i = 1; i < threads_cnt; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, convoyWorker, &jobs[i]) == 0;
+    }
+    if (threads_cnt > 0) {
+        convoyWorker(&jobs[0]);
+    }
+    for (int i = 1; i < threads_cnt; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            convoyWorker(&jobs[i]);
+        }
+    }
+
+    //merge per-thread counts, a camera belongs to exactly one thread so no event is counted twice
+    PARTNER_MAP merged;
+    partnerMapInit(&merged);
+    for (int i = 0; i < threads_cnt; ++i) {
+        for (int slot = 0; slot < jobs[i].map.slots_size; ++slot) {
+            if (jobs[i].map.plates[slot] != INDEX_SLOT_EMPTY) {
+                partnerMapAdd(&merged, jobs[i].map.plates[slot], INDEX_SLOT_EMPTY, jobs[i].map.counts[slot]);
+            }
+        }
+        partnerMapFree(&jobs[i].map);
+    }
+    free(groups);
+
+    CONVOY_PARTNER *partners = (CONVOY_PARTNER *) memoryRealloc(NULL, (merged.used + 1) * sizeof(CONVOY_PARTNER));
+    *partners_cnt = 0;
+    for (int slot = 0; slot < merged.slots_size; ++slot) {
+        if (merged.plates[slot] != INDEX_SLOT_EMPTY) {
+            partners[*partners_cnt].plate = merged.plates[slot];
+            partners[*partners_cnt].count = merged.counts[slot];
+            (*partners_cnt)++;
+        }
+    }
+    partnerMapFree(&merged);
+
+    sort_index = data->index;
+    qsort(partners, *partners_cnt, sizeof(CONVOY_PARTNER), compareConvoyPartners);
+
+    return partners;
+}
+
+/**
+ * initializes empty segment for $day
+ *
+ * @param segment
+ * @param day day in the store (@see segmentStoreTime())
+ */
+void segmentInit(SEGMENT *segment, int day) {
+    segment->day = day;
+    segment->sightings_cnt = 0;
+    segment->sightings_size = INDEX_SLOTS_INIT;
+    segment->sightings = (SEGMENT_SIGHTING *) memoryRealloc(NULL, segment->sightings_size * sizeof(SEGMENT_SIGHTING));
+    segment->pool_used = 0;
+    segment->pool_size = INDEX_SLOTS_INIT;
+    segment->pool = (char *) memoryRealloc(NULL, segment->pool_size);
+    segment->plates_cnt = 0;
+    segment->plates_size = INDEX_SLOTS_INIT / 2;
+    segment->plate_offsets = (int *) memoryRealloc(NULL, segment->plates_size * sizeof(int));
+    segment->slots_size = INDEX_SLOTS_INIT;
+    segment->slots = (int *) memoryRealloc(NULL, segment->slots_size * sizeof(int));
+    segment->plate_start = NULL;
+    segment->plate_sightings = NULL;
+    segment->indexed_cnt = -1;
+
+    for (int i = 0; i < segment->slots_size; ++i) {
+        segment->slots[i] = INDEX_SLOT_EMPTY;
+    }
+}
+
+/**
+ * frees all memory of $segment and marks it empty
+ *
+ * @param segment
+ */
+void segmentDrop(SEGMENT *segment) {
+    free(segment->sightings);
+    free(segment->pool);
+    free(segment->plate_offsets);
+    free(segment->slots);
+    free(segment->plate_start);
+    free(segment->plate_sightings);
+    segment->day = SEGMENT_EMPTY;
+}
+
+/**
+ * returns slot of $registration in $segment->slots, the slot is INDEX_SLOT_EMPTY if the plate is not in the segment
+ *
+ * @param segment
+ * @param registration
+ * @return slot position
+ */
+int segmentSlot(SEGMENT *segment, const char *registration) {
+    int mask = segment->slots_size - 1;
+    int slot = (int) (hashRegistration(registration) & (unsigned int) mask);
+
+    while (segment->slots[slot] != INDEX_SLOT_EMPTY &&
+           strcmp(segment->pool + segment->plate_offsets[segment->slots[slot]], registration) != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * adds sighting from $record to $segment
+ *
+ * @param segment
+ * @param record
+ * @param time time of $record in the store (@see segmentStoreTime())
+ */
+void segmentAdd(SEGMENT *segment, RECORD *record, int time) {
+    int slot = segmentSlot(segment, record->registration);
+
+    if (segment->slots[slot] == INDEX_SLOT_EMPTY) {
+        int len = (int) strlen(record->registration) + 1;
+
+        if (segment->pool_used + len > segment->pool_size) {
+            while (segment->pool_used + len > segment->pool_size) {
+                segment->pool_size *= 2;
+            }
+            segment->pool = (char *) memoryRealloc(segment->pool, segment->pool_size);
+        }
+
+        if (segment->plates_cnt >= segment->plates_size) {
+            segment->plates_size *= 2;
+            segment->plate_offsets = (int *) memoryRealloc(segment->plate_offsets, segment->plates_size * sizeof(int));
+        }
+
+        memcpy(segment->pool + segment->pool_used, record->registration, len);
+        segment->plate_offsets[segment->plates_cnt] = segment->pool_used;
+        segment->pool_used += len;
+        segment->slots[slot] = segment->plates_cnt++;
+
+        //keep load factor at most 1/2
+        if (segment->plates_cnt * 2 > segment->slots_size) {
+            free(segment->slots);
+            segment->slots_size *= 2;
+            segment->slots = (int *) memoryRealloc(NULL, segment->slots_size * sizeof(int));
+
+            for (int i = 0; i < segment->slots_size; ++i) {
+                segment->slots[i] = INDEX_SLOT_EMPTY;
+            }
+            for (int p = 0; p < segment->plates_cnt; ++p) {
+                segment->slots[segmentSlot(segment, segment->pool + segment->plate_offsets[p])] = p;
+            }
+
+            slot = segmentSlot(segment, record->registration);
+        }
+    }
+
+    if (segment->sightings_cnt >= segment->sightings_size) {
+        segment->sightings_size *= 2;
+        segment->sightings = (SEGMENT_SIGHTING *) memoryRealloc(segment->sightings,
+                                                                segment->sightings_size * sizeof(SEGMENT_SIGHTING));
+    }
+
+    segment->sightings[segment->sightings_cnt].plate = segment->slots[slot];
+    segment->sightings[segment->sightings_cnt].sighting.time = time;
+    segment->sightings[segment->sightings_cnt].sighting.camera_id = record->camera_id;
+    segment->sightings_cnt++;
+}
+
+/**
+ * (re)builds per-plate index of $segment if sightings were added since the last build
+ *
+ * @param segment
+ * @return SEGMENT* (same as $segment)
+ */
+SEGMENT *segmentIndexed(SEGMENT *segment) {
+    if (segment->indexed_cnt == segment->sightings_cnt) {
+        return segment;
+    }
+
+    segment->plate_start = (int *) memoryRealloc(segment->plate_start, (segment->plates_cnt + 1) * sizeof(int));
+    segment->plate_sightings = (SIGHTING *) memoryRealloc(segment->plate_sightings,
+                                                          (segment->sightings_cnt + 1) * sizeof(SIGHTING));
+    memset(segment->plate_start, 0, (segment->plates_cnt + 1) * sizeof(int));
+
+    //counting sort by plate, plate_start[p + 1] is used as fill position of plate p
+    for (int i = 0; i < segment->sightings_cnt; ++i) {
+        segment->plate_start[segment->sightings[i].plate + 1]++;
+    }
+    for (int p = 0; p < segment->plates_cnt; ++p) {
+        segment->plate_start[p + 1] += segment->plate_start[p];
+    }
+    for (int i = 0; i < segment->sightings_cnt; ++i) {
+        segment->plate_sightings[segment->plate_start[segment->sightings[i].plate]++] = segment->sightings[i].sighting;
+    }
+    for (int p = segment->plates_cnt; p > 0; --p) {
+        segment->plate_start[p] = segment->plate_start[p - 1];
+    }
+    segment->plate_start[0] = 0;
+
+    for (int p = 0; p < segment->plates_cnt; ++p) {
+        SIGHTING *sightings = &segment->plate_sightings[segment->plate_start[p]];
+        int sightings_cnt = segment->plate_start[p + 1] - segment->plate_start[p];
+
+        for (int i = 1; i < sightings_cnt; ++i) {
+            if (compareSightings(&sightings[i - 1], &sightings[i]) == AFTER) {
+                qsort(sightings, sightings_cnt, sizeof(SIGHTING), compareSightings);
+                break;
+            }
+        }
+    }
+
+    segment->indexed_cnt = segment->sightings_cnt;
+    return segment;
+}
+
+/**
+ * creates store keeping sightings of the last $retention_days days
+ *
+ * @param retention_days 1 - DAYS_PER_YEAR
+ * @return SEGMENT_STORE*
+ */
+SEGMENT_STORE *segmentStoreInit(int retention_days) {
+    SEGMENT_STORE *store = (SEGMENT_STORE *) memoryRealloc(NULL, sizeof(SEGMENT_STORE));
+
+    store->retention_days = retention_days;
+    store->newest_day = SEGMENT_EMPTY;
+    store->dropped_cnt = 0;
+    store->segments = (SEGMENT *) memoryRealloc(NULL, retention_days * sizeof(SEGMENT));
+
+    for (int i = 0; i < retention_days; ++i) {
+        store->segments[i].day = SEGMENT_EMPTY;
+    }
+
+    return store;
+}
+
+void segmentStoreFree(SEGMENT_STORE *store) {
+    for (int i = 0; i < store->retention_days; ++i) {
+        if (store->segments[i].day != SEGMENT_EMPTY) {
+            segmentDrop(&store->segments[i]);
+        }
+    }
+
+    free(store->segments);
+    free(store);
+}
+
+/**
+ * maps $time of input (minutes since Jan 1 of an unknown year) to time in $store
+ * the year closest to the newest sighting is taken, so Dec 31 -> Jan 1 moves into the next year
+ * and a late Dec 31 sighting after Jan 1 stays in the previous one
+ *
+ * @param store
+ * @param time minutes since Jan 1 00:00
+ * @return minutes since Jan 1 00:00 of year 0
+ */
+int segmentStoreTime(SEGMENT_STORE *store, int time) {
+    if (store->newest_day == SEGMENT_EMPTY) {
+        return MINUTES_PER_YEAR + time;
+    }
+
+    int year = store->newest_day / DAYS_PER_YEAR;
+    int day = year * DAYS_PER_YEAR + time / MINUTES_PER_DAY;
+
+    if (day < store->newest_day - DAYS_PER_YEAR / 2) {
+        year++;
+    } else if (day > store->newest_day + DAYS_PER_YEAR / 2) {
+        year--;
+    }
+
+    return year * MINUTES_PER_YEAR + time;
+}
+
+/**
+ * adds sighting from $record to the segment of its day
+ * a newer day expires segments that fall out of retention, sightings older than retention are dropped
+ *
+ * @param store
+ * @param record
+ */
+void segmentStoreAdd(SEGMENT_STORE *store, RECORD *record) {
+    int time = segmentStoreTime(store, getRecordMinutes(*record));
+    int day = time / MINUTES_PER_DAY;
+
+    if (store->newest_day == SEGMENT_EMPTY) {
+        store->newest_day = day;
+    } else if (day > store->newest_day) {
+        //only days (newest_day - retention_days, day - retention_days] expire, each has its own slot
+        for (int expired = store->newest_day - store->retention_days + 1;
+             expired <= day - store->retention_days && expired <= store->newest_day; ++expired) {
+            SEGMENT *segment = &store->segments[expired % store->retention_days];
+
+            if (segment->day == expired) {
+                segmentDrop(segment);
+            }
+        }
+
+        store->newest_day = day;
+    }
+
+    if (day <= store->newest_day - store->retention_days) {
+        store->dropped_cnt++;
+        return;
+    }
+
+    SEGMENT *segment = &store->segments[day % store->retention_days];
+    if (segment->day != day) {
+        segmentInit(segment, day);
+    }
+
+    segmentAdd(segment, record, time);
+}
+
+/**
+ * reads input (@see recordsRead()) straight into $store, records are not kept
+ *
+ * @param store
+ */
+void segmentStoreRead(SEGMENT_STORE *store) {
+    RECORD tmp;
+    char registration[REGISTRATION_MAX_LEN + 1];
+    char end;
+    int first = 1;
+
+    //read until } is found
+    while (1) {
+        if (recordRead(stdin, &tmp, registration, first, &end) == VALIDATE_ERROR) {
+            printf("Nespravny vstup.\n");
+            segmentStoreFree(store);
+            exit(0);
+        }
+
+        segmentStoreAdd(store, &tmp);
+        first = 0;
+
+        // } = end of input
+        if (end == '}') {
+            return;
+        }
+    }
+}
+
+/**
+ * returns plate of $registration in $segment, INDEX_SLOT_EMPTY if it is not there
+ *
+ * @param segment
+ * @param registration
+ * @return plate
+ */
+int segmentFind(SEGMENT *segment, const char *registration) {
+    return segment->slots[segmentSlot(segment, registration)];
+}
+
+/**
+ * prints collapsed sightings of the current gate, prints header before the first gate
+ *
+ * @param trajectory
+ */
+void trajectoryFlush(TRAJECTORY *trajectory) {
+    if (trajectory->hits == 0) {
+        return;
+    }
+
+    if (!trajectory->printed) {
+        printf("> Trasa:\n");
+        trajectory->printed = 1;
+    }
+
+    printf("  ");
+    printMinutes(trajectory->first.time);
+    printf(", %dx [%d]\n", trajectory->hits, trajectory->first.camera_id);
+    trajectory->hits = 0;
+}
+
+/**
+ * adds $sighting to streamed $trajectory, prints the previous gate once the plate moves to another one
+ *
+ * @param trajectory
+ * @param sighting
+ */
+void trajectoryAdd(TRAJECTORY *trajectory, SIGHTING sighting) {
+    if (trajectory->hits > 0 && trajectory->first.camera_id == sighting.camera_id) {
+        trajectory->hits++;
+        return;
+    }
+
+    trajectoryFlush(trajectory);
+    trajectory->first = sighting;
+    trajectory->hits = 1;
+}
+
+/**
+ * compares registrations of plates (positions in global $sort_index)
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+int comparePlates(const void *a, const void *b) {
+    return strcmp(sort_index->plates[*(const int *) a].registration, sort_index->plates[*(const int *) b].registration);
+}
+
+/**
+ * builds sorted dictionary of plates in $index, the index must not change while the dictionary is used
+ *
+ * @param index
+ * @return PLATE_DICTIONARY*
+ */
+PLATE_DICTIONARY *plateDictionaryBuild(PLATE_INDEX *index) {
+    PLATE_DICTIONARY *dictionary = (PLATE_DICTIONARY *) memoryRealloc(NULL, sizeof(PLATE_DICTIONARY));
+
+    dictionary->index = index;
+    dictionary->plates_cnt = index->plates_cnt;
+    dictionary->plates = (int *) memoryRealloc(NULL, (index->plates_cnt + 1) * sizeof(int));
+
+    for (int i = 0; i < index->plates_cnt; ++i) {
+        dictionary->plates[i] = i;
+    }
+
+    //plates of the index are already distinct, sorting is enough
+    sort_index = index;
+    qsort(dictionary->plates, dictionary->plates_cnt, sizeof(int), comparePlates);
+
+    //char buckets by counting sort, filled in dictionary order so every bucket is sorted
+    int buckets_cnt = DICTIONARY_POSITIONS * DICTIONARY_CHARS;
+    dictionary->bucket_start = (int *) memoryRealloc(NULL, (buckets_cnt + 1) * sizeof(int));
+    memset(dictionary->bucket_start, 0, (buckets_cnt + 1) * sizeof(int));
+
+    for (int i = 0; i < dictionary->plates_cnt; ++i) {
+        const char *registration = index->plates[dictionary->plates[i]].registration;
+
+        for (int p = 0; p < DICTIONARY_POSITIONS && registration[p]; ++p) {
+            dictionary->bucket_start[p * DICTIONARY_CHARS + (unsigned char) registration[p] + 1]++;
+        }
+    }
+    for (int b = 0; b < buckets_cnt; ++b) {
+        dictionary->bucket_start[b + 1] += dictionary->bucket_start[b];
+    }
+
+    dictionary->buckets = (int *) memoryRealloc(NULL, (dictionary->bucket_start[buckets_cnt] + 1) * sizeof(int));
+    for (int i = 0; i < dictionary->plates_cnt; ++i) {
+        const char *registration = index->plates[dictionary->plates[i]].registration;
+
+        for (int p = 0; p < DICTIONARY_POSITIONS && registration[p]; ++p) {
+            dictionary->buckets[dictionary->bucket_start[p * DICTIONARY_CHARS + (unsigned char) registration[p]]++] = i;
+        }
+    }
+    for (int b = buckets_cnt; b > 0; --b) {
+        dictionary->bucket_start[b] = dictionary->bucket_start[b - 1];
+    }
+    dictionary->bucket_start[0] = 0;
+
+    return dictionary;
+}
+
+void plateDictionaryFree(PLATE_DICTIONARY *dictionary) {
+    free(dictionary->plates);
+    free(dictionary->bucket_start);
+    free(dictionary->buckets);
+    free(dictionary);
+}
+
+/**
+ * returns position of the first plate in $dictionary that is not smaller than $prefix (first $len chars of it)
+ *
+ * @param dictionary
+ * @param prefix
+ * @param len
+ * @return position in $dictionary->plates
+ */
+int plateDictionaryLowerBound(PLATE_DICTIONARY *dictionary, const char *prefix, int len) {
+    int low = 0;
+    int high = dictionary->plates_cnt;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strncmp(dictionary->index->plates[dictionary->plates[mid]].registration, prefix, len) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * returns position of the first plate in $dictionary whose first $len chars are greater than $prefix
+ *
+ * @param dictionary
+ * @param prefix
+ * @param len
+ * @return position in $dictionary->plates
+ */
+int plateDictionaryUpperBound(PLATE_DICTIONARY *dictionary, const char *prefix, int len) {
+    int low = 0;
+    int high = dictionary->plates_cnt;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strncmp(dictionary->index->plates[dictionary->plates[mid]].registration, prefix, len) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * returns position of the first value in sorted $values that is not smaller than $value
+ *
+ * @param values
+ * @param values_cnt
+ * @param value
+ * @return position in $values
+ */
+int intsLowerBound(const int *values, int values_cnt, int value) {
+    int low = 0;
+    int high = values_cnt;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (values[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * matches $str against $pattern, WILDCARD_ANY matches any (also empty) sequence, WILDCARD_ONE matches one char
+ *
+ * @param pattern
+ * @param str
+ * @return 1 if $str matches, 0 otherwise
+ */
+int matchWildcard(const char *pattern, const char *str) {
+    const char *star = NULL;
+    const char *star_str = NULL;
+
+    while (*str) {
+        if (*pattern == WILDCARD_ANY) {
+            //remember the star, try to match it with nothing first
+            star = pattern++;
+            star_str = str;
+        } else if (*pattern == WILDCARD_ONE || *pattern == *str) {
+            pattern++;
+            str++;
+        } else if (star != NULL) {
+            //mismatch, let the last star swallow one more char
+            pattern = star + 1;
+            str = ++star_str;
+        } else {
+            return 0;
+        }
+    }
+
+    while (*pattern == WILDCARD_ANY) {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
+
+/**
+ * returns candidates of $dictionary that can match $pattern, as part [*from, *to) of *candidates (ascending positions
+ * in $dictionary->plates), or as range [*from, *to) of $dictionary->plates itself if *candidates is NULL
+ * the range holds plates starting with the literal prefix of the pattern (chars before the first wildcard),
+ * it is narrowed to the smallest char bucket of a literal char before the first WILDCARD_ANY
+ * (position < DICTIONARY_POSITIONS), so a query costs O(prefix * log n + the smallest such bucket in the range)
+ * patterns with no literal char before the first WILDCARD_ANY (e.g. "*-12") still scan the whole prefix range
+ *
+ * @param dictionary
+ * @param pattern
+ * @param candidates
+ * @param from
+ * @param to
+ */
+void plateDictionaryRange(PLATE_DICTIONARY *dictionary, const char *pattern, const int **candidates, int *from,
+                          int *to) {
+    int len = (int) strcspn(pattern, "*?");
+    int fixed = (int) strcspn(pattern, "*");
+
+    int range_from = plateDictionaryLowerBound(dictionary, pattern, len);
+    int range_to = plateDictionaryUpperBound(dictionary, pattern, len);
+
+    *candidates = NULL;
+    *from = range_from;
+    *to = range_to;
+
+    for (int p = len; p < fixed && p < DICTIONARY_POSITIONS; ++p) {
+        if (pattern[p] == WILDCARD_ONE) {
+            continue;
+        }
+
+        int bucket = p * DICTIONARY_CHARS + (unsigned char) pattern[p];
+        const int *values = dictionary->buckets + dictionary->bucket_start[bucket];
+        int values_cnt = dictionary->bucket_start[bucket + 1] - dictionary->bucket_start[bucket];
+        int bucket_from = intsLowerBound(values, values_cnt, range_from);
+        int bucket_to = intsLowerBound(values, values_cnt, range_to);
+
+        if (bucket_to - bucket_from < *to - *from) {
+            *candidates = values;
+            *from = bucket_from;
+            *to = bucket_to;
+        }
+    }
+}
+
+/**
+ * 64 bit hash of registration plate for HyperLogLog (FNV-1a followed by splitmix64 finalizer)
+ *
+ * @param registration
+ * @return hash
+ */
+uint64_t hashRegistration64(const char *registration) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (; *registration; ++registration) {
+        hash ^= (unsigned char) *registration;
+        hash *= 1099511628211ull;
+    }
+
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+/**
+ * adds $registration to HyperLogLog sketch $hll
+ * first HLL_BITS of the hash pick the register, the register keeps the longest run of leading zeros (+ 1) seen
+ *
+ * @param hll HLL_REGISTERS registers
+ * @param registration
+ */
+void hllAdd(unsigned char *hll, const char *registration) {
+    uint64_t hash = hashRegistration64(registration);
+    int reg = (int) (hash >> (64 - HLL_BITS));
+    uint64_t rest = hash << HLL_BITS;
+    unsigned char rank = 1;
+
+    while (rank <= 64 - HLL_BITS && !(rest & ((uint64_t) 1 << 63))) {
+        rest <<= 1;
+        rank++;
+    }
+
+    if (hll[reg] < rank) {
+        hll[reg] = rank;
+    }
+}
+
+/**
+ * estimated number of distinct values added to $hll, small cardinalities are estimated by linear counting
+ *
+ * @param hll
+ * @return estimate
+ */
+double hllEstimate(const unsigned char *hll) {
+    double sum = 0;
+    int zeros = 0;
+
+    for (int i = 0; i < HLL_REGISTERS; ++i) {
+        sum += 1.0 / (double) ((uint64_t) 1 << hll[i]);
+        zeros += hll[i] == 0;
+    }
+
+    //alpha for 64 registers
+    double estimate = 0.709 * HLL_REGISTERS * HLL_REGISTERS / sum;
+
+    if (estimate <= 2.5 * HLL_REGISTERS && zeros > 0) {
+        estimate = HLL_REGISTERS * log((double) HLL_REGISTERS / zeros);
+    }
+
+    return estimate;
+}
+
+/**
+ * creates empty traffic cube
+ *
+ * @return ROLLUP*
+ */
+ROLLUP *rollupInit() {
+    ROLLUP *cube = (ROLLUP *) memoryRealloc(NULL, sizeof(ROLLUP));
+
+    cube->cameras_cnt = 0;
+    cube->cameras_size = INDEX_SLOTS_INIT / 2;
+    cube->cameras = (ROLLUP_CAMERA **) memoryRealloc(NULL, cube->cameras_size * sizeof(ROLLUP_CAMERA *));
+    cube->slots_size = INDEX_SLOTS_INIT;
+    cube->slots = (int *) memoryRealloc(NULL, cube->slots_size * sizeof(int));
+
+    for (int i = 0; i < cube->slots_size; ++i) {
+        cube->slots[i] = INDEX_SLOT_EMPTY;
+    }
+
+    return cube;
+}
+
+void rollupFree(ROLLUP *cube) {
+    for (int c = 0; c < cube->cameras_cnt; ++c) {
+        for (int d = 0; d < DAYS_PER_YEAR; ++d) {
+            free(cube->cameras[c]->days[d]);
+        }
+        free(cube->cameras[c]);
+    }
+
+    free(cube->cameras);
+    free(cube->slots);
+    free(cube);
+}
+
+/**
+ * returns slot of $camera_id in $cube->slots, the slot is INDEX_SLOT_EMPTY if the camera is not in the cube
+ *
+ * @param cube
+ * @param camera_id
+ * @return slot position
+ */
+int rollupSlot(ROLLUP *cube, int camera_id) {
+    int mask = cube->slots_size - 1;
+    int slot = (int) (((unsigned int) camera_id * 2654435761u) & (unsigned int) mask);
+
+    while (cube->slots[slot] != INDEX_SLOT_EMPTY && cube->cameras[cube->slots[slot]]->camera_id != camera_id) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/**
+ * returns camera $camera_id of $cube, NULL if the camera saw nothing
+ *
+ * @param cube
+ * @param camera_id
+ * @return ROLLUP_CAMERA*
+ */
+ROLLUP_CAMERA *rollupFind(ROLLUP *cube, int camera_id) {
+    int camera = cube->slots[rollupSlot(cube, camera_id)];
+
+    return camera == INDEX_SLOT_EMPTY ? NULL : cube->cameras[camera];
+}
+
+/**
+ * counts sighting from $record in its camera x day x hour cell
+ *
+ * @param cube
+ * @param record
+ */
+void rollupAdd(ROLLUP *cube, RECORD *record) {
+    int slot = rollupSlot(cube, record->camera_id);
+
+    if (cube->slots[slot] == INDEX_SLOT_EMPTY) {
+        if (cube->cameras_cnt >= cube->cameras_size) {
+            cube->cameras_size *= 2;
+            cube->cameras = (ROLLUP_CAMERA **) memoryRealloc(cube->cameras,
+                                                             cube->cameras_size * sizeof(ROLLUP_CAMERA *));
+        }
+
+        ROLLUP_CAMERA *camera = (ROLLUP_CAMERA *) memoryRealloc(NULL, sizeof(ROLLUP_CAMERA));
+        camera->camera_id = record->camera_id;
+        for (int d = 0; d < DAYS_PER_YEAR; ++d) {
+            camera->days[d] = NULL;
+        }
+
+        cube->cameras[cube->cameras_cnt] = camera;
+        cube->slots[slot] = cube->cameras_cnt++;
+
+        //keep load factor at most 1/2
+        if (cube->cameras_cnt * 2 > cube->slots_size) {
+            free(cube->slots);
+            cube->slots_size *= 2;
+            cube->slots = (int *) memoryRealloc(NULL, cube->slots_size * sizeof(int));
+
+            for (int i = 0; i < cube->slots_size; ++i) {
+                cube->slots[i] = INDEX_SLOT_EMPTY;
+            }
+            for (int c = 0; c < cube->cameras_cnt; ++c) {
+                cube->slots[rollupSlot(cube, cube->cameras[c]->camera_id)] = c;
+            }
+
+            slot = rollupSlot(cube, record->camera_id);
+        }
+    }
+
+    ROLLUP_CAMERA *camera = cube->cameras[cube->slots[slot]];
+    int day = getRecordMinutes(*record) / MINUTES_PER_DAY;
+
+    if (camera->days[day] == NULL) {
+        camera->days[day] = (ROLLUP_CELL *) memoryRealloc(NULL, HOURS_PER_DAY * sizeof(ROLLUP_CELL));
+        memset(camera->days[day], 0, HOURS_PER_DAY * sizeof(ROLLUP_CELL));
+    }
+
+    ROLLUP_CELL *cell = &camera->days[day][record->hour];
+    cell->count++;
+    hllAdd(cell->hll, record->registration);
+}
+
+/**
+ * sums cells of $camera for each hour of day over days [from_day, to_day], HLL sketches are merged
+ * $from_day > $to_day is a window over New Year, days [from_day, Dec 31] and [Jan 1, to_day] are summed
+ *
+ * @param camera
+ * @param from_day
+ * @param to_day
+ * @param hours HOURS_PER_DAY cells, output
+ */
+void rollupHours(ROLLUP_CAMERA *camera, int from_day, int to_day, ROLLUP_CELL *hours) {
+    memset(hours, 0, HOURS_PER_DAY * sizeof(ROLLUP_CELL));
+
+    int days_cnt = (to_day - from_day + DAYS_PER_YEAR) % DAYS_PER_YEAR + 1;
+    for (int i = 0; i < days_cnt; ++i) {
+        int day = (from_day + i) % DAYS_PER_YEAR;
+
+        if (camera->days[day] == NULL) {
+            continue;
+        }
+
+        for (int hour = 0; hour < HOURS_PER_DAY; ++hour) {
+            ROLLUP_CELL *cell = &camera->days[day][hour];
+
+            hours[hour].count += cell->count;
+            for (int i = 0; i < HLL_REGISTERS; ++i) {
+                if (hours[hour].hll[i] < cell->hll[i]) {
+                    hours[hour].hll[i] = cell->hll[i];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * reads input (@see recordsRead()) straight into a new traffic cube, records are not kept
+ *
+ * @return ROLLUP*
+ */
+ROLLUP *rollupRead() {
+    ROLLUP *cube = rollupInit();
+    RECORD tmp;
+    char registration[REGISTRATION_MAX_LEN + 1];
+    char end;
+    int first = 1;
+
+    //read until } is found
+    while (1) {
+        if (recordRead(stdin, &tmp, registration, first, &end) == VALIDATE_ERROR) {
+            printf("Nespravny vstup.\n");
+            rollupFree(cube);
+            exit(0);
+        }
+
+        rollupAdd(cube, &tmp);
+        first = 0;
+
+        // } = end of input
+        if (end == '}') {
+            return cube;
+        }
+    }
+}
+
+/**
+ * try to find $registration in $records_array, creates new $found_records array and returns it, size of $found_records is returned in $found_size
+ *
+ * @param records_array array of records in which the desired registration number is being found
+ * @param records_cnt size of $records_array
+ * @param registration
+ * @param found_size size of the newly created array
+ * @return array of records with matching registration number
+ */
+RECORD *getRecordsRegistration(RECORD *records_array, int records_cnt, char *registration, int *found_size) {
+    int j = 0; //index in found_records array
+    RECORD *found_records = (RECORD *) malloc(*found_size * sizeof(RECORD));
+
+    //iterate over records_array, if registrations are matching add it to found_records
+    for (int i = 0; i < records_cnt; ++i) {
+        if (strcmp(records_array[i].registration, registration) == 0) {
+            if (j >= *found_size) {
+                *found_size += 1;
+                RECORD *tmp_realloc = (RECORD *) realloc(found_records, *found_size * sizeof(RECORD));
+
+                if (tmp_realloc == NULL) {
+                    free(found_records);
+                    free(records_array);
+                    printf("Nedostatek pameti.\n");
+                    exit(0);
+                }
+
+                found_records = tmp_realloc;
+            }
+
+            found_records[j] = records_array[i];
+            j++;
+        }
+    }
+
+    return found_records;
+
+}
+
+/**
+ * returns all sightings of a registration number that is stored in $record_query
+ *
+ * cmp_val values:
+ *      EXACT  => query == records_array[item]
+ *      AFTER  => query >  records_array[item]
+ *      BEFORE => query <  records_array[item]
+ *
+ * @param records_array
+ * @param records_array_size
+ * @param record_query
+ * @param cnt
+ * @param cmp_val
+ * @return RECORD array and its size as cnt
+ */
+RECORD *getSightings(RECORD *records_array, int records_array_size, RECORD record_query, int *cnt, int cmp_val) {
+
+    int res_size = 1;
+    int compare;
+
+    RECORD *query_results = (RECORD *) malloc(res_size * sizeof(RECORD));
+
+
+
+    //iterate over records_array and look for matching registration numbers
+    for (int i = 0; i < records_array_size; ++i) {
+        record_query.camera_id = records_array[i].camera_id;
+        compare = compareRecords(&records_array[i], &record_query);
+
+        if (compare == cmp_val) {
+            *cnt += 1;
+
+            if ((*cnt - 1) >= res_size) {
+                res_size += 1;
+                RECORD *tmp = (RECORD *) realloc(query_results, res_size * sizeof(RECORD));
+
+                if (tmp == NULL) {
+                    free(records_array);
+                    printf("Nedostatek pameti.\n");
+                    exit(0);
+                }
+
+                query_results = tmp;
+            }
+
+            //use $cnt as index by subtracting 1
+            query_results[*cnt - 1] = records_array[i];
+        }
+    }
+
+    return query_results;
+}
+
+/**
+ * returns a new (usually smaller) array of records where:
+ * A) the times of all records match
+ * B) the times are the highest ones in original array
+ *
+ * @param records_array
+ * @param records_array_size
+ * @param cnt
+ * @return
+ */
+RECORD *getMaximums(RECORD *records_array, int records_array_size, int *cnt) {
+    RECORD max = records_array[records_array_size - 1];
+    *cnt = 0;
+    int ids_arr_size = 1;
+    RECORD *max_ids = (RECORD *) malloc(ids_arr_size * sizeof(RECORD));
+
+    for (int i = 0; i < records_array_size; ++i) {
+        RECORD pseudo_record = records_array[i];
+
+        if (compareRecordsIgnoreId(&pseudo_record, &max) == EXACT) {
+            *cnt += 1;
+
+            if ((*cnt - 1) >= ids_arr_size) {
+                ids_arr_size += 1;
+                RECORD *tmp = (RECORD *) realloc(max_ids, ids_arr_size * sizeof(RECORD));
+
+                if (tmp == NULL) {
+                    free(records_array);
+                    printf("Nedostatek pameti.\n");
+                    exit(0);
+                }
+
+                max_ids = tmp;
+            }
+            max_ids[*cnt - 1] = pseudo_record;
+        }
+    }
+
+    return max_ids;
+}
+
+/**
+ * @see getMaximums(), except minimums
+ *
+ * @param records_array
+ * @param records_array_size
+ * @param cnt
+ * @return
+ */
+RECORD *getMinimums(RECORD *records_array, int records_array_size, int *cnt) {
+    qsort(records_array, records_array_size, sizeof(RECORD), compareRecordsIgnoreId);
+    RECORD min = records_array[0];
+    *cnt = 0;
+    int ids_arr_size = 1;
+    RECORD *min_ids = (RECORD *) malloc(ids_arr_size * sizeof(RECORD));
+
+    for (int i = 0; i < records_array_size; ++i) {
+        RECORD pseudo_record = records_array[i];
+        min.camera_id = pseudo_record.camera_id;
+        if (compareRecords(&pseudo_record, &min) == EXACT) {
+            *cnt += 1;
+
+            if ((*cnt - 1) >= ids_arr_size) {
+                ids_arr_size += 1;
+                RECORD *tmp = (RECORD *) realloc(min_ids, ids_arr_size * sizeof(RECORD));
+
+                if (tmp == NULL) {
+                    free(records_array);
                     printf("Nedostatek pameti.\n");
                     exit(0);
                 }
 
-                query_results = tmp;
-            }
+                min_ids = tmp;
+            }
+            min_ids[*cnt - 1] = pseudo_record;
+        }
+    }
+
+    return min_ids;
+}
+
+/**
+ * tries to find records of $find_registration in $records_array and prints the result for the queried date
+ *
+ * @param records_array
+ * @param records_cnt size of $records_array
+ * @param find_registration
+ * @param month_str
+ * @param find_day
+ * @param find_hour
+ * @param find_minute
+ */
+void queryRecords(RECORD *records_array, int records_cnt, char *find_registration, char *month_str, int find_day,
+                  int find_hour, int find_minute) {
+    int find_month;
+    char month_print[4];
+
+    int found_size = 0;
+
+    find_month = getMonthToInt(month_str);
+    RECORD *found_records = getRecordsRegistration(records_array, records_cnt, find_registration, &found_size);
+
+    //create a pseudo record with the query params
+    RECORD pseudo_record;
+    pseudo_record.registration = records_array[0].registration;
+    pseudo_record.month = find_month;
+    pseudo_record.day = find_day;
+    pseudo_record.hour = find_hour;
+    pseudo_record.minute = find_minute;
+
+    //query params invalid
+    if (validateRecord(pseudo_record) == VALIDATE_ERROR || find_month == MONTH_ERR) {
+        printf("Nespravny vstup.\n");
+        free(records_array);
+        exit(0);
+    }
+
+    int exact_cnt = 0;
+
+    if (found_size > 0) {
+        //attempt to find exact time matches
+        RECORD *exact_cam_id_array = getSightings(found_records, found_size, pseudo_record, &exact_cnt, EXACT);
+
+        if (exact_cnt >= 1) {
+            //exact matches were found, print and continue
+            printf("> Presne: %s %d %02d:%02d, %dx [", month_str, find_day, find_hour, find_minute, exact_cnt);
+            for (int i = 0; i < exact_cnt - 1; ++i) {
+                printf("%d, ", exact_cam_id_array[i].camera_id);
+            }
+            printf("%d]\n", exact_cam_id_array[exact_cnt - 1].camera_id);
+            free(exact_cam_id_array);
+            free(found_records);
+            return;
+        }
+        free(exact_cam_id_array);
+
+        qsort(found_records, found_size, sizeof(RECORD), compareRecordsIgnoreId);
+
+        //attempt to find time matches before and after query times
+        int before_cnt = 0;
+        RECORD *before_cam_id_array = getSightings(found_records, found_size, pseudo_record, &before_cnt, BEFORE);
+
+        int after_cnt = 0;
+        RECORD *after_cam_id_array = getSightings(found_records, found_size, pseudo_record, &after_cnt, AFTER);
+
+        if (after_cnt >= 1 || before_cnt >= 1) {
+            //after or before was found, print each non-empty result and continue
+
+            if (before_cnt >= 1) {
+                //print before
+                int max_cnt;
+                RECORD *maximums = getMaximums(before_cam_id_array, before_cnt, &max_cnt);
+
+                getIntToMonth(maximums[max_cnt - 1].month, month_print);
+                if (strcmp(month_print, "ERR") == 0) {
+                    exit(10);
+                }
+
+                printf("> Predchazejici: %s %d %02d:%02d, %dx [", month_print, maximums[max_cnt - 1].day,
+                       maximums[max_cnt - 1].hour, maximums[max_cnt - 1].minute, max_cnt);
+                for (int i = 0; i < max_cnt - 1; ++i) {
+                    printf("%d, ", maximums[i].camera_id);
+                }
+                printf("%d]\n", maximums[max_cnt - 1].camera_id);
+                free(maximums);
+
+            } else {
+                printf("> Predchazejici: N/A\n");
+            }
+
+            if (after_cnt >= 1) {
+                //print after
+                int min_cnt;
+                RECORD *minimums = getMinimums(after_cam_id_array, after_cnt, &min_cnt);
+
+
+                getIntToMonth(minimums[min_cnt - 1].month, month_print);
+                if (strcmp(month_print, "ERR") == 0) {
+                    exit(10);
+                }
+
+                printf("> Pozdejsi: %s %d %02d:%02d, %dx [", month_print, minimums[min_cnt - 1].day,
+                       minimums[min_cnt - 1].hour, minimums[min_cnt - 1].minute, min_cnt);
+                for (int i = 0; i < min_cnt - 1; ++i) {
+                    printf("%d, ", minimums[i].camera_id);
+                }
+                printf("%d]\n", minimums[min_cnt - 1].camera_id);
+                free(minimums);
+
+            } else {
+                printf("> Pozdejsi: N/A\n");
+            }
+            free(before_cam_id_array);
+            free(after_cam_id_array);
+            free(found_records);
+            return;
+        } else {
+            //registration not found
+            printf("> Automobil nenalezen.\n");
+        }
+        free(before_cam_id_array);
+        free(after_cam_id_array);
+
+    } else {
+        //registration not found
+        printf("> Automobil nenalezen.\n");
+    }
+
+    free(found_records);
+}
+
+
+/**
+ * reads one registration number and date from stdin, tries to find records in $records_array and prints the result
+ *
+ * @param records_array
+ * @return 0 if input ended, 1 otherwise
+ */
+int queryNext(RECORD *records_array) {
+    int find_day, find_hour, find_minute;
+    char month_str[4], find_registration[1001];
+
+    int input = scanf("%s %s %d %d:%d", find_registration, month_str, &find_day, &find_hour, &find_minute);
+    if (input != 5) {
+        return 0;
+    }
+
+    queryRecords(records_array, size, find_registration, month_str, find_day, find_hour, find_minute);
+    return 1;
+}
+/**
+ * main function for finding registration records in the $records_array
+ * reads registration numbers and dates from stdin, tries to find records in $records_array
+ *
+ * @param records_array
+ */
+void query(RECORD *records_array) {
+    while (queryNext(records_array)) {
+    }
+}
+
+/**
+ * reads time in format %b %d %H:%M from stdin, returns it as minutes since Jan 1 00:00 (@see getRecordMinutes())
+ * program exits if the time is invalid
+ *
+ * @param records_array freed on invalid input
+ * @param time
+ * @return 0 if input ended, 1 otherwise
+ */
+int queryReadTime(RECORD *records_array, int *time) {
+    RECORD pseudo_record;
+    char month_str[MONTH_LEN + 1];
+
+    if (scanf("%4s %d %d:%d", month_str, &pseudo_record.day, &pseudo_record.hour, &pseudo_record.minute) != 4) {
+        return 0;
+    }
+
+    pseudo_record.month = strlen(month_str) == MONTH_LEN - 1 ? getMonthToInt(month_str) : MONTH_ERR;
+
+    //query params invalid
+    if (pseudo_record.month == MONTH_ERR || validateRecord(pseudo_record) == VALIDATE_ERROR) {
+        printf("Nespravny vstup.\n");
+        free(records_array);
+        exit(0);
+    }
+
+    *time = getRecordMinutes(pseudo_record);
+    return 1;
+}
+
+/**
+ * trajectory mode, reads registration numbers and time windows from stdin
+ * prints cameras the plate passed in the window ordered by time, repeated hits at the same gate are collapsed
+ * results are streamed straight from the sorted sightings of the plate, O(log n + k) per query
+ *
+ * @param records_array
+ * @param index plate index over $records_array
+ */
+void queryTrajectory(RECORD *records_array, PLATE_INDEX *index) {
+    char find_registration[1001];
+    int from, to;
+
+    while (1) {
+        if (scanf("%1000s", find_registration) != 1 || !queryReadTime(records_array, &from) ||
+            !queryReadTime(records_array, &to)) {
+            break;
+        }
+
+        PLATE *plate = plateIndexFind(index, find_registration);
+        if (plate == NULL) {
+            printf("> Automobil nenalezen.\n");
+            continue;
+        }
+
+        plateIndexSorted(plate);
+
+        TRAJECTORY trajectory = {{0, 0}, 0, 0};
+        int i = sightingsLowerBound(plate->sightings, plate->sightings_cnt, from);
+
+        while (i < plate->sightings_cnt && plate->sightings[i].time <= to) {
+            trajectoryAdd(&trajectory, plate->sightings[i]);
+            i++;
+        }
+
+        trajectoryFlush(&trajectory);
+        if (!trajectory.printed) {
+            printf("> Trasa: N/A\n");
+        }
+    }
+}
+
+/**
+ * retention mode, answers trajectory queries (@see queryTrajectory()) from $store
+ * only segments of days overlapping the queried window are probed
+ *
+ * @param store
+ */
+void querySegments(SEGMENT_STORE *store) {
+    char find_registration[1001];
+    int from, to;
+
+    while (1) {
+        if (scanf("%1000s", find_registration) != 1 || !queryReadTime(NULL, &from) || !queryReadTime(NULL, &to)) {
+            break;
+        }
+
+        //window is taken in the year(s) closest to the newest sighting, a window over New Year ends in the later one
+        from = segmentStoreTime(store, from);
+        to = segmentStoreTime(store, to);
+        if (from > to) {
+            from -= MINUTES_PER_YEAR;
+        }
+
+        int oldest_day = store->newest_day - store->retention_days + 1;
+        int from_day = from / MINUTES_PER_DAY < oldest_day ? oldest_day : from / MINUTES_PER_DAY;
+        int to_day = to / MINUTES_PER_DAY > store->newest_day ? store->newest_day : to / MINUTES_PER_DAY;
+        TRAJECTORY trajectory = {{0, 0}, 0, 0};
+
+        for (int day = from_day; day <= to_day; ++day) {
+            SEGMENT *segment = &store->segments[day % store->retention_days];
+            if (segment->day != day) {
+                continue;
+            }
+
+            int plate = segmentFind(segment, find_registration);
+            if (plate == INDEX_SLOT_EMPTY) {
+                continue;
+            }
+
+            segmentIndexed(segment);
+            SIGHTING *sightings = &segment->plate_sightings[segment->plate_start[plate]];
+            int sightings_cnt = segment->plate_start[plate + 1] - segment->plate_start[plate];
+
+            for (int i = sightingsLowerBound(sightings, sightings_cnt, from);
+                 i < sightings_cnt && sightings[i].time <= to; ++i) {
+                trajectoryAdd(&trajectory, sightings[i]);
+            }
+        }
+
+        trajectoryFlush(&trajectory);
+        if (trajectory.printed) {
+            continue;
+        }
+
+        //nothing in the window, tell apart unknown plates
+        int known = 0;
+        for (int i = 0; i < store->retention_days && !known; ++i) {
+            known = store->segments[i].day != SEGMENT_EMPTY &&
+                    segmentFind(&store->segments[i], find_registration) != INDEX_SLOT_EMPTY;
+        }
+
+        printf(known ? "> Trasa: N/A\n" : "> Automobil nenalezen.\n");
+    }
+}
+
+/**
+ * fuzzy mode, reads registration numbers and maximal edit distances from stdin
+ * prints every known plate within the distance, closest plates first
+ *
+ * @param records_array
+ * @param index plate index over $records_array
+ */
+void queryFuzzy(RECORD *records_array, PLATE_INDEX *index) {
+    char find_registration[1001];
+    int max_distance;
+    FUZZY_INDEX *fuzzy = fuzzyIndexBuild(index);
+
+    while (1) {
+        if (scanf("%1000s %d", find_registration, &max_distance) != 2) {
+            break;
+        }
+
+        //query params invalid
+        if (max_distance < 0 || max_distance > FUZZY_MAX_DISTANCE) {
+            printf("Nespravny vstup.\n");
+            fuzzyIndexFree(fuzzy);
+            plateIndexFree(index);
+            free(records_array);
+            exit(0);
+        }
+
+        int matches_cnt;
+        FUZZY_MATCH *matches = fuzzyIndexFind(fuzzy, find_registration, max_distance, &matches_cnt);
+
+        if (matches_cnt == 0) {
+            printf("> Automobil nenalezen.\n");
+        } else {
+            printf("> Podobne:\n");
+            for (int i = 0; i < matches_cnt; ++i) {
+                PLATE *plate = &index->plates[matches[i].plate];
+                printf("  %s (%d), %dx\n", plate->registration, matches[i].distance, plate->sightings_cnt);
+            }
+        }
+
+        free(matches);
+    }
+
+    fuzzyIndexFree(fuzzy);
+}
+
+/**
+ * convoy mode, reads registration numbers and time differences (minutes) from stdin
+ * prints up to CONVOY_TOP plates most often seen at the same camera within the difference of the queried plate
+ *
+ * @param records_array
+ * @param data convoy data over $records_array
+ */
+void queryConvoy(RECORD *records_array, CONVOY_DATA *data) {
+    char find_registration[1001];
+    int delta;
+
+    while (1) {
+        if (scanf("%1000s %d", find_registration, &delta) != 2) {
+            break;
+        }
+
+        //query params invalid
+        if (delta < 0) {
+            printf("Nespravny vstup.\n");
+            convoyFree(data);
+            free(records_array);
+            exit(0);
+        }
+
+        int slot = plateIndexSlot(data->index, find_registration);
+        if (data->index->slots[slot] == INDEX_SLOT_EMPTY) {
+            printf("> Automobil nenalezen.\n");
+            continue;
+        }
+
+        int partners_cnt;
+        CONVOY_PARTNER *partners = convoyFind(data, data->index->slots[slot], delta, &partners_cnt);
+
+        if (partners_cnt == 0) {
+            printf("> Spolujizda: N/A\n");
+        } else {
+            printf("> Spolujizda:\n");
+            for (int i = 0; i < partners_cnt && i < CONVOY_TOP; ++i) {
+                printf("  %s, %dx\n", data->index->plates[partners[i].plate].registration, partners[i].count);
+            }
+        }
+
+        free(partners);
+    }
+}
+
+/**
+ * search mode, reads plate patterns from stdin (@see matchWildcard())
+ * prints every known plate matching the pattern in alphabetical order with the number of its sightings
+ *
+ * @param dictionary sorted dictionary of all plates
+ */
+void querySearch(PLATE_DICTIONARY *dictionary) {
+    char pattern[1001];
+
+    while (1) {
+        if (scanf("%1000s", pattern) != 1) {
+            break;
+        }
+
+        const int *candidates;
+        int from, to;
+        int found = 0;
+        plateDictionaryRange(dictionary, pattern, &candidates, &from, &to);
+
+        for (int i = from; i < to; ++i) {
+            int position = candidates != NULL ? candidates[i] : i;
+            PLATE *plate = &dictionary->index->plates[dictionary->plates[position]];
+
+            if (!matchWildcard(pattern, plate->registration)) {
+                continue;
+            }
+
+            if (!found) {
+                printf("> Nalezeno:\n");
+                found = 1;
+            }
+            printf("  %s, %dx\n", plate->registration, plate->sightings_cnt);
+        }
+
+        if (!found) {
+            printf("> Automobil nenalezen.\n");
+        }
+    }
+}
+
+/**
+ * rollup mode, reads camera ids and day ranges from stdin
+ * prints sightings per hour of day summed over the days and estimated number of distinct plates
+ *
+ * @param cube traffic cube of the input (@see rollupRead())
+ */
+void queryRollup(ROLLUP *cube) {
+    int camera_id;
+    int from, to;
+
+    while (1) {
+        if (scanf("%d", &camera_id) != 1 || !queryReadTime(NULL, &from) || !queryReadTime(NULL, &to)) {
+            break;
+        }
+
+        ROLLUP_CAMERA *camera = rollupFind(cube, camera_id);
+        if (camera == NULL) {
+            printf("> Kamera nenalezena.\n");
+            continue;
+        }
+
+        ROLLUP_CELL hours[HOURS_PER_DAY];
+        int found = 0;
+        rollupHours(camera, from / MINUTES_PER_DAY, to / MINUTES_PER_DAY, hours);
+
+        for (int hour = 0; hour < HOURS_PER_DAY; ++hour) {
+            if (hours[hour].count == 0) {
+                continue;
+            }
+
+            if (!found) {
+                printf("> Provoz:\n");
+                found = 1;
+            }
+            printf("  %02d:00, %dx, ~%.0f\n", hour, hours[hour].count, hllEstimate(hours[hour].hll));
+        }
+
+        if (!found) {
+            printf("> Provoz: N/A\n");
+        }
+    }
+}
+
+/**
+ * xorshift64* pseudo random generator
+ *
+ * @param state non-zero state, updated
+ * @return next random number
+ */
+uint64_t randomNext(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 2685821657736338717ull;
+}
+
+/**
+ * @param state
+ * @return random number in [0, 1)
+ */
+double randomUniform(uint64_t *state) {
+    return (double) (randomNext(state) >> 11) / (double) ((uint64_t) 1 << 53);
+}
+
+/**
+ * returns random plate from [0, $plates_cnt) following Zipf distribution given by cumulative weights $cdf
+ *
+ * @param cdf cumulative weights of plates, cdf[plates_cnt - 1] is the total weight
+ * @param plates_cnt
+ * @param state
+ * @return plate
+ */
+int randomPlate(double *cdf, int plates_cnt, uint64_t *state) {
+    double u = randomUniform(state) * cdf[plates_cnt - 1];
+    int low = 0;
+    int high = plates_cnt - 1;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (cdf[mid] <= u) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * prints registration of generated plate $plate (AAA-00-00 - ZZZ-99-99)
+ *
+ * @param plate
+ */
+void printGeneratedPlate(int plate) {
+    int letters = plate / GENERATE_PLATE_DIGITS;
+    int digits = plate % GENERATE_PLATE_DIGITS;
+
+    printf("%c%c%c-%02d-%02d", 'A' + letters / (26 * 26), 'A' + letters / 26 % 26, 'A' + letters % 26,
+           digits / 100, digits % 100);
+}
+
+/**
+ * reads whole stdin into a null terminated buffer
+ *
+ * @param length length of the buffer without the terminator
+ * @return buffer, must be freed
+ */
+char *inputReadAll(long *length) {
+    long buffer_size = INPUT_CHUNK;
+    char *buffer = (char *) memoryRealloc(NULL, buffer_size);
+    size_t read;
+
+    *length = 0;
+    while ((read = fread(buffer + *length, 1, buffer_size - *length - 1, stdin)) > 0) {
+        *length += (long) read;
+
+        if (buffer_size - *length - 1 == 0) {
+            buffer_size *= 2;
+            buffer = (char *) memoryRealloc(buffer, buffer_size);
+        }
+    }
+
+    buffer[*length] = '\0';
+    return buffer;
+}
+
+/**
+ * appends $record to $bucket
+ *
+ * @param bucket
+ * @param record
+ */
+void recordBucketAdd(RECORD_BUCKET *bucket, RECORD *record) {
+    if (bucket->cnt >= bucket->size) {
+        bucket->size = bucket->size == 0 ? SIZE : bucket->size * 2;
+        bucket->records = (RECORD *) memoryRealloc(bucket->records, bucket->size * sizeof(RECORD));
+    }
+
+    bucket->records[bucket->cnt++] = *record;
+}
+
+/**
+ * @param registration
+ * @param shards_cnt
+ * @return shard owning all records of $registration
+ */
+int shardOf(const char *registration, int shards_cnt) {
+    return (int) (hashRegistration(registration) % (unsigned int) shards_cnt);
+}
+
+/**
+ * parses records of one input chunk (@see recordRead()), stops after '}' or at the end of the chunk
+ * the chunk starting at offset 0 begins with '{', any other chunk begins right after ','
+ *
+ * @param arg SHARD_PARSE_JOB*
+ * @return NULL
+ */
+void *shardParseWorker(void *arg) {
+    SHARD_PARSE_JOB *job = (SHARD_PARSE_JOB *) arg;
+    long length = job->end - job->start;
+
+    job->failed = 0;
+    job->terminator = -1;
+    platePoolInit(&job->pool);
+    for (int i = 0; i < job->shards_cnt; ++i) {
+        job->buckets[i].records = NULL;
+        job->buckets[i].cnt = 0;
+        job->buckets[i].size = 0;
+    }
+
+    if (length == 0) {
+        return NULL;
+    }
 
-            //use $cnt as index by subtracting 1
-            query_results[*cnt - 1] = records_array[i];
+    FILE *stream = fmemopen(job->input + job->start, length, "r");
+    if (stream == NULL) {
+        job->failed = 1;
+        return NULL;
+    }
+
+    RECORD tmp;
+    char registration[REGISTRATION_MAX_LEN + 1];
+    char end;
+    int first = job->start == 0;
+
+    while (ftell(stream) < length) {
+        if (recordRead(stream, &tmp, registration, first, &end) == VALIDATE_ERROR) {
+            job->failed = 1;
+            break;
+        }
+        first = 0;
+        tmp.registration = platePoolAdd(&job->pool, registration);
+
+        recordBucketAdd(&job->buckets[shardOf(tmp.registration, job->shards_cnt)], &tmp);
+
+        if (end == '}') {
+            job->terminator = job->start + ftell(stream);
+            break;
         }
     }
 
-    return query_results;
+    fclose(stream);
+    return NULL;
 }
 
 /**
- * returns a new (usually smaller) array of records where:
- * A) the times of all records match
- * B) the times are the highest ones in original array
+ * orders records by registration, then as compareRecords()
  *
- * @param records_array
- * @param records_array_size
- * @param cnt
- * @return
+ * @param a
+ * @param b
+ * @return int
  */
-RECORD *getMaximums(RECORD *records_array, int records_array_size, int *cnt) {
-    RECORD max = records_array[records_array_size - 1];
-    *cnt = 0;
-    int ids_arr_size = 1;
-    RECORD *max_ids = (RECORD *) malloc(ids_arr_size * sizeof(RECORD));
+int compareRecordsPlate(const void *a, const void *b) {
+    int compare = strcmp(((const RECORD *) a)->registration, ((const RECORD *) b)->registration);
 
-    for (int i = 0; i < records_array_size; ++i) {
-        RECORD pseudo_record = records_array[i];
+    if (compare != 0) {
+        return compare < 0 ? BEFORE : AFTER;
+    }
 
-        if (compareRecordsIgnoreId(&pseudo_record, &max) == EXACT) {
-            *cnt += 1;
+    return compareRecords(a, b);
+}
 
-            if ((*cnt - 1) >= ids_arr_size) {
-                ids_arr_size += 1;
-                RECORD *tmp = (RECORD *) realloc(max_ids, ids_arr_size * sizeof(RECORD));
+/**
+ * @param arg SHARD_MERGE_JOB*
+ * @return NULL
+ */
+void *shardMergeWorker(void *arg) {
+    SHARD_MERGE_JOB *job = (SHARD_MERGE_JOB *) arg;
+    RECORD_BUCKET *shard = job->records;
 
-                if (tmp == NULL) {
-                    free(records_array);
-                    printf("Nedostatek pameti.\n");
-                    exit(0);
-                }
+    shard->cnt = 0;
+    for (int i = 0; i < job->parse_jobs_cnt; ++i) {
+        shard->cnt += job->parse_jobs[i].buckets[job->shard].cnt;
+    }
 
-                max_ids = tmp;
-            }
-            max_ids[*cnt - 1] = pseudo_record;
+    //empty shard keeps one zeroed record, queryRecords() reads the first record of the array
+    shard->size = shard->cnt > 0 ? shard->cnt : SIZE;
+    shard->records = (RECORD *) memoryRealloc(NULL, shard->size * sizeof(RECORD));
+    memset(shard->records, 0, sizeof(RECORD));
+
+    int index = 0;
+    for (int i = 0; i < job->parse_jobs_cnt; ++i) {
+        RECORD_BUCKET *bucket = &job->parse_jobs[i].buckets[job->shard];
+
+        if (bucket->cnt > 0) {
+            memcpy(&shard->records[index], bucket->records, bucket->cnt * sizeof(RECORD));
+            index += bucket->cnt;
         }
+        free(bucket->records);
     }
 
-    return max_ids;
+    //sort shard by plate, then id, month, day, hour, minute, sightings of one plate keep the order of the default mode
+    qsort(shard->records, shard->cnt, sizeof(RECORD), compareRecordsPlate);
+    return NULL;
 }
 
 /**
- * @see getMaximums(), except minimums
+ * returns range [*from, *to) of records of $registration in $shard sorted by compareRecordsPlate()
  *
- * @param records_array
- * @param records_array_size
- * @param cnt
- * @return
+ * @param shard
+ * @param registration
+ * @param from
+ * @param to
  */
-RECORD *getMinimums(RECORD *records_array, int records_array_size, int *cnt) {
-    qsort(records_array, records_array_size, sizeof(RECORD), compareRecordsIgnoreId);
-    RECORD min = records_array[0];
-    *cnt = 0;
-    int ids_arr_size = 1;
-    RECORD *min_ids = (RECORD *) malloc(ids_arr_size * sizeof(RECORD));
+void shardFind(RECORD_BUCKET *shard, const char *registration, int *from, int *to) {
+    int low = 0;
+    int high = shard->cnt;
 
-    for (int i = 0; i < records_array_size; ++i) {
-        RECORD pseudo_record = records_array[i];
-        min.camera_id = pseudo_record.camera_id;
-        if (compareRecords(&pseudo_record, &min) == EXACT) {
-            *cnt += 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
 
-            if ((*cnt - 1) >= ids_arr_size) {
-                ids_arr_size += 1;
-                RECORD *tmp = (RECORD *) realloc(min_ids, ids_arr_size * sizeof(RECORD));
+        if (strcmp(shard->records[mid].registration, registration) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *from = low;
 
-                if (tmp == NULL) {
-                    free(records_array);
-                    printf("Nedostatek pameti.\n");
-                    exit(0);
-                }
+    high = shard->cnt;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
 
-                min_ids = tmp;
-            }
-            min_ids[*cnt - 1] = pseudo_record;
+        if (strcmp(shard->records[mid].registration, registration) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
+    *to = low;
+}
 
-    return min_ids;
+/**
+ * runs $jobs_cnt jobs of $worker, job 0 runs on the calling thread, so does every job whose thread can't be created
+ *
+ * @param worker
+ * @param jobs
+ * @param job_size size of one job
+ * @param jobs_cnt
+ */
+void shardRun(void *(*worker)(void *), void *jobs, size_t job_size, int jobs_cnt) {
+    pthread_t threads[SHARDS_MAX];
+    int started[SHARDS_MAX];
+
+    for (int i = 1; i < jobs_cnt; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, worker, (char *) jobs + i * job_size) == 0;
+    }
+    worker(jobs);
+    for (int i = 1; i < jobs_cnt; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            worker((char *) jobs + i * job_size);
+        }
+    }
 }
 
 /**
- * main function for finding registration records in the $records_array
- * reads registration numbers and dates from stdin, tries to find records in $records_array
+ * splits $input into $jobs_cnt chunks at record boundaries (after ',') and parses them in parallel
  *
- * @param records_array
+ * @param input
+ * @param length
+ * @param jobs
+ * @param jobs_cnt
+ * @param shards_cnt
+ * @return offset just after '}', -1 if the chunks could not be parsed
  */
-void query(RECORD *records_array) {
-    int find_month, find_day, find_hour, find_minute;
-    char month_str[4], find_registration[1001];
-    char month_print[4];
+long shardParse(char *input, long length, SHARD_PARSE_JOB *jobs, int jobs_cnt, int shards_cnt) {
+    long start = 0;
 
-    while (1) {
-        int found_size = 0;
-        int input = scanf("%s %s %d %d:%d", find_registration, month_str, &find_day, &find_hour, &find_minute);
-        if (input != 5) {
-            break;
+    for (int i = 0; i < jobs_cnt; ++i) {
+        long end = i == jobs_cnt - 1 ? length : length / jobs_cnt * (i + 1);
+
+        if (end < start) {
+            end = start;
+        }
+        while (end < length && (end == 0 || input[end - 1] != ',')) {
+            end++;
         }
 
+        jobs[i].input = input;
+        jobs[i].start = start;
+        jobs[i].end = end;
+        jobs[i].shards_cnt = shards_cnt;
+        start = end;
+    }
 
+    shardRun(shardParseWorker, jobs, sizeof(SHARD_PARSE_JOB), jobs_cnt);
 
-        find_month = getMonthToInt(month_str);
-        RECORD *found_records = getRecordsRegistration(records_array, find_registration, &found_size);
+    //chunks before the one containing '}' must be parsed whole, chunks after it hold queries
+    long terminator = -1;
+    for (int i = 0; i < jobs_cnt; ++i) {
+        if (terminator != -1) {
+            for (int j = 0; j < shards_cnt; ++j) {
+                free(jobs[i].buckets[j].records);
+                jobs[i].buckets[j].records = NULL;
+                jobs[i].buckets[j].cnt = 0;
+            }
+        } else if (jobs[i].terminator != -1) {
+            terminator = jobs[i].terminator;
+        } else if (jobs[i].failed) {
+            terminator = -2;
+        }
+    }
 
-        //create a pseudo record with the query params
-        RECORD pseudo_record;
-        strcpy(pseudo_record.registration, records_array[0].registration);
-        pseudo_record.month = find_month;
-        pseudo_record.day = find_day;
-        pseudo_record.hour = find_hour;
-        pseudo_record.minute = find_minute;
+    if (terminator < 0) {
+        for (int i = 0; i < jobs_cnt; ++i) {
+            for (int j = 0; j < shards_cnt; ++j) {
+                free(jobs[i].buckets[j].records);
+            }
+            platePoolFree(&jobs[i].pool);
+        }
+        return -1;
+    }
 
-        //query params invalid
-        if (validateRecord(pseudo_record) == VALIDATE_ERROR || find_month == MONTH_ERR) {
-            printf("Nespravny vstup.\n");
-            free(records_array);
+    return terminator;
+}
+
+/**
+ * shards mode, input is parsed by $threads_cnt threads and records are split by plate hash into the same number
+ * of shards, each shard is sorted by plate on its own thread and queries are answered from the sightings of the plate
+ * in the shard owning it
+ * output is the same as in the default mode
+ *
+ * @param threads_cnt 0 = number of CPUs
+ */
+void shardsRun(int threads_cnt) {
+    if (threads_cnt == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_cnt = cpus < 1 ? 1 : (cpus > SHARDS_MAX ? SHARDS_MAX : (int) cpus);
+    }
+
+    long length;
+    char *input = inputReadAll(&length);
+    SHARD_PARSE_JOB *parse_jobs = (SHARD_PARSE_JOB *) memoryRealloc(NULL, threads_cnt * sizeof(SHARD_PARSE_JOB));
+
+    int parse_jobs_cnt = threads_cnt;
+    long terminator = shardParse(input, length, parse_jobs, parse_jobs_cnt, threads_cnt);
+    if (terminator == -1 && threads_cnt > 1) {
+        //a chunk did not start at a record boundary (',' inside a registration), parse input as one chunk
+        parse_jobs_cnt = 1;
+        terminator = shardParse(input, length, parse_jobs, parse_jobs_cnt, threads_cnt);
+    }
+
+    if (terminator == -1) {
+        printf("Nespravny vstup.\n");
+        free(parse_jobs);
+        free(input);
+        exit(0);
+    }
+
+    SHARD_MERGE_JOB merge_jobs[SHARDS_MAX];
+    RECORD_BUCKET shards[SHARDS_MAX];
+
+    for (int i = 0; i < threads_cnt; ++i) {
+        merge_jobs[i].parse_jobs = parse_jobs;
+        merge_jobs[i].parse_jobs_cnt = parse_jobs_cnt;
+        merge_jobs[i].shard = i;
+        merge_jobs[i].records = &shards[i];
+    }
+    shardRun(shardMergeWorker, merge_jobs, sizeof(SHARD_MERGE_JOB), threads_cnt);
+
+    printf("Hledani:\n");
+
+    //queries follow '}' in the same buffer
+    if (length > terminator) {
+        FILE *queries = fmemopen(input + terminator, length - terminator, "r");
+        if (queries == NULL) {
+            printf("Nedostatek pameti.\n");
             exit(0);
         }
 
-        int exact_cnt = 0;
+        int find_day, find_hour, find_minute;
+        char month_str[MONTH_LEN + 1], find_registration[1001];
 
-        if (found_size > 0) {
-            //attempt to find exact time matches
-            RECORD *exact_cam_id_array = getSightings(found_records, found_size, pseudo_record, &exact_cnt, EXACT);
+        while (fscanf(queries, "%1000s %4s %d %d:%d", find_registration, month_str, &find_day, &find_hour,
+                      &find_minute) == 5) {
+            RECORD_BUCKET *shard = &shards[shardOf(find_registration, threads_cnt)];
+            RECORD pseudo_record;
+            int from, to;
 
-            if (exact_cnt >= 1) {
-                //exact matches were found, print and continue
-                printf("> Presne: %s %d %02d:%02d, %dx [", month_str, find_day, find_hour, find_minute, exact_cnt);
-                for (int i = 0; i < exact_cnt - 1; ++i) {
-                    printf("%d, ", exact_cam_id_array[i].camera_id);
-                }
-                printf("%d]\n", exact_cam_id_array[exact_cnt - 1].camera_id);
-                continue;
+            //validated here, queryRecords() frees the array it got on invalid query and that is a part of the shard
+            pseudo_record.month = strlen(month_str) == MONTH_LEN - 1 ? getMonthToInt(month_str) : MONTH_ERR;
+            pseudo_record.day = find_day;
+            pseudo_record.hour = find_hour;
+            pseudo_record.minute = find_minute;
+            if (pseudo_record.month == MONTH_ERR || validateRecord(pseudo_record) == VALIDATE_ERROR) {
+                printf("Nespravny vstup.\n");
+                exit(0);
             }
 
-            qsort(found_records, found_size, sizeof(RECORD), compareRecordsIgnoreId);
+            shardFind(shard, find_registration, &from, &to);
+            queryRecords(shard->records + (from < to ? from : 0), to - from, find_registration, month_str, find_day,
+                         find_hour, find_minute);
+        }
+
+        fclose(queries);
+    }
+    for (int i = 0; i < threads_cnt; ++i) {
+        free(shards[i].records);
+        platePoolFree(&parse_jobs[i].pool);
+    }
+    free(parse_jobs);
+    free(input);
+}
 
-            //attempt to find time matches before and after query times
-            int before_cnt = 0;
-            RECORD *before_cam_id_array = getSightings(found_records, found_size, pseudo_record, &before_cnt, BEFORE);
+/**
+ * @param a
+ * @param b
+ * @return greatest common divisor of $a and $b
+ */
+int greatestCommonDivisor(int a, int b) {
+    while (b != 0) {
+        int rest = a % b;
+        a = b;
+        b = rest;
+    }
 
-            int after_cnt = 0;
-            RECORD *after_cam_id_array = getSightings(found_records, found_size, pseudo_record, &after_cnt, AFTER);
+    return a;
+}
 
-            if (after_cnt >= 1 || before_cnt >= 1) {
-                //after or before was found, print each non-empty result and continue
+/**
+ * generate mode, prints random camera data and queries for the default mode to stdout
+ * arguments (after --generate): sightings [plates] [skew] [cameras] [queries] [seed]
+ * plate popularity follows Zipf distribution with exponent $skew (0 = uniform), times are spread over the year
+ *
+ * @param argc
+ * @param argv
+ */
+void generateInput(int argc, char *argv[]) {
+    int sightings_cnt = 0;
+    int plates_cnt = 0;
+    double skew = 1.0;
+    int cameras_cnt = 100;
+    int queries_cnt = 1000;
+    unsigned long long seed = GENERATE_SEED;
+    char month_print[4];
 
-                if (before_cnt >= 1) {
-                    //print before
-                    int max_cnt;
-                    RECORD *maximums = getMaximums(before_cam_id_array, before_cnt, &max_cnt);
+    if (argc < 3 || sscanf(argv[2], "%d", &sightings_cnt) != 1 || sightings_cnt < 1 ||
+        (argc > 3 && sscanf(argv[3], "%d", &plates_cnt) != 1) ||
+        (argc > 4 && sscanf(argv[4], "%lf", &skew) != 1) ||
+        (argc > 5 && sscanf(argv[5], "%d", &cameras_cnt) != 1) ||
+        (argc > 6 && sscanf(argv[6], "%d", &queries_cnt) != 1) ||
+        (argc > 7 && sscanf(argv[7], "%llu", &seed) != 1)) {
+        printf("Nespravny vstup.\n");
+        exit(0);
+    }
 
-                    getIntToMonth(maximums[max_cnt - 1].month, month_print);
-                    if (strcmp(month_print, "ERR") == 0) {
-                        exit(10);
-                    }
+    if (argc <= 3) {
+        plates_cnt = sightings_cnt / 10 > 0 ? sightings_cnt / 10 : 1;
+    }
 
-                    printf("> Predchazejici: %s %d %02d:%02d, %dx [", month_print, maximums[max_cnt - 1].day,
-                           maximums[max_cnt - 1].hour, maximums[max_cnt - 1].minute, max_cnt);
-                    for (int i = 0; i < max_cnt - 1; ++i) {
-                        printf("%d, ", maximums[i].camera_id);
-                    }
-                    printf("%d]\n", maximums[max_cnt - 1].camera_id);
+    if (plates_cnt < 1 || plates_cnt > GENERATE_PLATES_MAX || skew < 0 || cameras_cnt < 1 || queries_cnt < 0 ||
+        seed == 0) {
+        printf("Nespravny vstup.\n");
+        exit(0);
+    }
 
-                } else {
-                    printf("> Predchazejici: N/A\n");
-                }
+    uint64_t state = seed;
+    double *cdf = (double *) memoryRealloc(NULL, plates_cnt * sizeof(double));
+    double total = 0;
 
-                if (after_cnt >= 1) {
-                    //print after
-                    int min_cnt;
-                    RECORD *minimums = getMinimums(after_cam_id_array, after_cnt, &min_cnt);
+    for (int i = 0; i < plates_cnt; ++i) {
+        total += skew == 0 ? 1.0 : 1.0 / pow(i + 1, skew);
+        cdf[i] = total;
+    }
 
+    //plate ids are scattered over the whole AAA-00-00 - ZZZ-99-99 space so that plates (popular ones too) do not
+    //share a prefix, golden ratio step puts consecutive ids far apart, step coprime with GENERATE_PLATES_MAX keeps
+    //different ids different plates
+    int plate_step = (int) (GENERATE_PLATES_MAX * 0.6180339887);
+    while (greatestCommonDivisor(plate_step, GENERATE_PLATES_MAX) != 1) {
+        plate_step++;
+    }
 
-                    getIntToMonth(minimums[min_cnt - 1].month, month_print);
-                    if (strcmp(month_print, "ERR") == 0) {
-                        exit(10);
-                    }
+    printf("{");
+    for (int i = 0; i < sightings_cnt; ++i) {
+        RECORD pseudo_record;
+        int plate = (int) ((long long) randomPlate(cdf, plates_cnt, &state) * plate_step % GENERATE_PLATES_MAX);
 
-                    printf("> Pozdejsi: %s %d %02d:%02d, %dx [", month_print, minimums[min_cnt - 1].day,
-                           minimums[min_cnt - 1].hour, minimums[min_cnt - 1].minute, min_cnt);
-                    for (int i = 0; i < min_cnt - 1; ++i) {
-                        printf("%d, ", minimums[i].camera_id);
-                    }
-                    printf("%d]\n", minimums[min_cnt - 1].camera_id);
+        getMinutesToRecord((int) (randomNext(&state) % (DAYS_PER_YEAR * MINUTES_PER_DAY)), &pseudo_record);
+        getIntToMonth(pseudo_record.month, month_print);
 
-                } else {
-                    printf("> Pozdejsi: N/A\n");
-                }
-                free(found_records);
-                continue;
-            } else {
-                //registration not found
-                printf("> Automobil nenalezen.\n");
-            }
+        printf("%d: ", (int) (randomNext(&state) % cameras_cnt) + 1);
+        printGeneratedPlate(plate);
+        printf(" %s %d %d:%02d%s\n", month_print, pseudo_record.day, pseudo_record.hour, pseudo_record.minute,
+               i + 1 < sightings_cnt ? "," : "}");
+    }
 
-        } else {
-            //registration not found
-            printf("> Automobil nenalezen.\n");
+    for (int i = 0; i < queries_cnt; ++i) {
+        RECORD pseudo_record;
+        int plate = (int) ((long long) randomPlate(cdf, plates_cnt, &state) * plate_step % GENERATE_PLATES_MAX);
+
+        getMinutesToRecord((int) (randomNext(&state) % (DAYS_PER_YEAR * MINUTES_PER_DAY)), &pseudo_record);
+        getIntToMonth(pseudo_record.month, month_print);
+
+        printGeneratedPlate(plate);
+        printf(" %s %d %d:%02d\n", month_print, pseudo_record.day, pseudo_record.hour, pseudo_record.minute);
+    }
+
+    free(cdf);
+}
+
+/**
+ * @return monotonic time in seconds
+ */
+double benchNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+int compareDoubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+
+    return da > db ? AFTER : (da < db ? BEFORE : EXACT);
+}
+
+/**
+ * bench mode, runs the default mode (input, sort, queries) and prints timings of each phase to stderr
+ * query results still go to stdout
+ */
+void bench() {
+    PLATE_POOL pool;
+    platePoolInit(&pool);
+
+    double start = benchNow();
+    RECORD *records = recordsRead(&pool);
+    double ingest = benchNow() - start;
+    long bytes = ftell(stdin);
+
+    start = benchNow();
+    qsort(records, size, sizeof(RECORD), compareRecords);
+    double sort = benchNow() - start;
+
+    printf("Hledani:\n");
+
+    int latencies_size = SIZE;
+    int latencies_cnt = 0;
+    double *latencies = (double *) memoryRealloc(NULL, latencies_size * sizeof(double));
+
+    while (1) {
+        start = benchNow();
+        if (!queryNext(records)) {
+            break;
+        }
+
+        if (latencies_cnt >= latencies_size) {
+            latencies_size *= 2;
+            latencies = (double *) memoryRealloc(latencies, latencies_size * sizeof(double));
+        }
+        latencies[latencies_cnt++] = benchNow() - start;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "records: %d\n", size);
+    if (bytes > 0) {
+        fprintf(stderr, "ingest: %.3f s, %.1f MB/s\n", ingest, (double) bytes / 1e6 / ingest);
+    } else {
+        //stdin is a pipe, size of input is unknown
+        fprintf(stderr, "ingest: %.3f s\n", ingest);
+    }
+    fprintf(stderr, "sort: %.3f s\n", sort);
+    fprintf(stderr, "peak RSS: %ld KB\n", usage.ru_maxrss);
+
+    if (latencies_cnt > 0) {
+        qsort(latencies, latencies_cnt, sizeof(double), compareDoubles);
+        fprintf(stderr, "queries: %d, p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n", latencies_cnt,
+                latencies[latencies_cnt / 2] * 1e6, latencies[latencies_cnt * 9 / 10] * 1e6,
+                latencies[latencies_cnt * 99 / 100] * 1e6, latencies[latencies_cnt - 1] * 1e6);
+    }
+
+    free(latencies);
+    free(records);
+    platePoolFree(&pool);
+}
+
+/**
+ * returns MODE_* selected by first program argument, program exits if the argument is unknown
+ *
+ * @param argc
+ * @param argv
+ * @param mode_arg numeric argument of the mode (--retention days)
+ * @return mode
+ */
+int getMode(int argc, char *argv[], int *mode_arg) {
+    if (argc < 2) {
+        return MODE_DEFAULT;
+    }
+
+    if (strcmp(argv[1], "--trajectory") == 0) {
+        return MODE_TRAJECTORY;
+    }
+
+    if (strcmp(argv[1], "--fuzzy") == 0) {
+        return MODE_FUZZY;
+    }
+
+    if (strcmp(argv[1], "--convoy") == 0) {
+        return MODE_CONVOY;
+    }
+
+    if (strcmp(argv[1], "--generate") == 0) {
+        return MODE_GENERATE;
+    }
+
+    if (strcmp(argv[1], "--bench") == 0) {
+        return MODE_BENCH;
+    }
+
+    if (strcmp(argv[1], "--rollup") == 0) {
+        return MODE_ROLLUP;
+    }
+
+    if (strcmp(argv[1], "--search") == 0) {
+        return MODE_SEARCH;
+    }
+
+    if (strcmp(argv[1], "--shards") == 0) {
+        if (argc <= 2) {
+            *mode_arg = 0;
+            return MODE_SHARDS;
+        }
+
+        if (sscanf(argv[2], "%d", mode_arg) == 1 && *mode_arg >= 1 && *mode_arg <= SHARDS_MAX) {
+            return MODE_SHARDS;
         }
+    }
 
-        free(found_records);
+    if (strcmp(argv[1], "--retention") == 0 && argc > 2 && sscanf(argv[2], "%d", mode_arg) == 1 &&
+        *mode_arg >= 1 && *mode_arg <= DAYS_PER_YEAR) {
+        return MODE_RETENTION;
     }
+
+    printf("Nespravny vstup.\n");
+    exit(0);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
 
     /*
      * algorithm:
@@ -629,18 +4058,96 @@ int main() {
      *  3.3) try finding exact time matches, print results and goto 3) if not empty
      *  3.4) try finding matches before/after query time, print results if not empty
      * 4) goto 3)
+     *
+     * --trajectory: 2) build per-plate sighting index, 3) answer trajectory queries from the index
+     * --fuzzy: 2) build per-plate sighting index and deletion-neighbourhood index over its plates,
+     *          3) answer fuzzy queries by looking up query variants and verifying candidates
+     * --convoy: 2) map records to plates and cameras, 3) answer convoy queries by sweeping cameras of the plate in parallel
+     * --search: 2) build per-plate sighting index and sorted plate dictionary over it,
+     *           3) answer pattern queries from the dictionary range sharing the literal prefix of the pattern,
+     *              narrowed to the smallest per-position char bucket of the literal chars before the first *
+     * --shards: 1) parse chunks of input in parallel, route records into shards by plate hash, 2) sort shards in parallel,
+     *           3) look up each query in the shard owning its plate
+     * --generate: print random input instead, --bench: default mode with timings printed to stderr
+     * --rollup: 1) count every record into camera x day x hour cube while reading (nothing else is kept), 2) skipped,
+     *          3) answer traffic queries from the cube
+     * --retention: 1) add records to per-day segments of the last N days (nothing else is kept), 2) skipped,
+     *              3) answer trajectory queries from segments overlapping the window
      */
 
+    int mode_arg = 0;
+    int mode = getMode(argc, argv, &mode_arg);
+
+    if (mode == MODE_GENERATE) {
+        generateInput(argc, argv);
+        return 0;
+    }
+
     printf("Data z kamer:\n");
-    RECORD *records = recordsRead();
+
+    if (mode == MODE_BENCH) {
+        bench();
+        return 0;
+    }
+
+    if (mode == MODE_SHARDS) {
+        shardsRun(mode_arg);
+        return 0;
+    }
+
+    if (mode == MODE_RETENTION) {
+        SEGMENT_STORE *store = segmentStoreInit(mode_arg);
+        segmentStoreRead(store);
+
+        printf("Hledani:\n");
+        querySegments(store);
+
+        segmentStoreFree(store);
+        return 0;
+    }
+
+    if (mode == MODE_ROLLUP) {
+        ROLLUP *cube = rollupRead();
+
+        printf("Hledani:\n");
+        queryRollup(cube);
+
+        rollupFree(cube);
+        return 0;
+    }
+
+    PLATE_POOL pool;
+    platePoolInit(&pool);
+    RECORD *records = recordsRead(&pool);
 
     //sort input by id, month, day, hour, minute
     qsort(records, size, sizeof(RECORD), compareRecords);
 
     printf("Hledani:\n");
-    query(records);
+    if (mode == MODE_TRAJECTORY) {
+        PLATE_INDEX *index = plateIndexBuild(records, size);
+        queryTrajectory(records, index);
+        plateIndexFree(index);
+    } else if (mode == MODE_FUZZY) {
+        PLATE_INDEX *index = plateIndexBuild(records, size);
+        queryFuzzy(records, index);
+        plateIndexFree(index);
+    } else if (mode == MODE_CONVOY) {
+        CONVOY_DATA *data = convoyBuild(records, size);
+        queryConvoy(records, data);
+        convoyFree(data);
+    } else if (mode == MODE_SEARCH) {
+        PLATE_INDEX *index = plateIndexBuild(records, size);
+        PLATE_DICTIONARY *dictionary = plateDictionaryBuild(index);
+        querySearch(dictionary);
+        plateDictionaryFree(dictionary);
+        plateIndexFree(index);
+    } else {
+        query(records);
+    }
 
     free(records);
+    platePoolFree(&pool);
 
     return 0;
 }
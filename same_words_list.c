@@ -3,6 +3,48 @@
  * goal = compare both strings to see if every word (separated by " ") in string A is also present in string B and vice versa, NOT case sensitive, extra whitespaces can be ignored
  *
  * Single struct method
+ *
+ * sameWords() compares hash sets of words (words of A are inserted, words of B are looked up, first miss ends the
+ * comparison), sameWordsSorted() is the original sort + dedupe method, kept as reference
+ * sameWords() does one heap allocation - normalized words of A, their spans, the set and the current word of B live
+ * in one bump arena
+ * input is normalized by format_chunk() - SSE2/AVX2 kernel selected at runtime on x86, scalar str_format() rules
+ * otherwise (ASCII classification, same as isspace()/isalpha() in the default "C" locale)
+ *
+ * sameWordsFingerprint() - 128-bit fingerprint of the word set of one string (sum of MurmurHash3 of unique words),
+ * equal word sets have equal fingerprints, sameWordsGroups() groups many strings by fingerprint and verifies
+ * groups by sameWords()
+ *
+ * sameWordsMinHash() - MinHash signature of the word set of one string, sameWordsSimilarity() estimates Jaccard
+ * similarity of two word sets from their signatures, sameWordsCandidates() finds similar pairs among many signatures
+ * by LSH banding
+ *
+ * sameWordsFiles() - sameWords() over two files read in chunks, memory depends on the number of unique words of the
+ * first file, not on the size of the files
+ *
+ * sameWordsParallel() - sameWords() on more threads, both strings are split at word boundaries and tokenized at once,
+ * words are partitioned by hash so every partition is compared by one thread without locks
+ *
+ * sameWordsRadix() - sorted-list method on word spans, words are sorted by multikey quicksort (char by char, no
+ * strcmp() from the start of words) and duplicates are dropped during the sort, tokenize_sorted() returns the sorted
+ * vocabulary of one string
+ *
+ * word_table - reusable set of words that owns them, words up to TABLE_INLINE chars are stored in the slot itself,
+ * longer ones in a side pool, every word has a stored hash and a dense id (order of insertion) for per-word arrays
+ * sameWords() does not use it - a word_table copies every word and needs its own slots and pool (2+ allocations that
+ * grow), while sameWords() keeps spans into the normalized text and sizes everything from strlen() up front, so text,
+ * spans and set share the one arena allocation; word_table is for sets that outlive one call (files, library, tracker)
+ *
+ * word_library - inverted index of stored documents (word id -> documents with the word), finds documents with
+ * exactly / at least / at most the words of a string in time of postings of its words, documents can be added and
+ * removed one by one
+ *
+ * word_tracker - sameWords() of two documents that are being edited, keeps number of occurrences of every word in
+ * both documents and number of words that are only in one of them, an edit (words added / deleted, or a byte range
+ * replaced) re-tokenizes only the words it touches, the answer is then known at once
+ *
+ * test build: no arguments = asserts, --fuzz [rounds] = every engine against sameWordsSorted() on generated pairs,
+ * --bench [MB] = MB/s and heap allocations per call of every engine on generated corpora
  */ 
 
 #ifndef __PROGTEST__
@@ -12,14 +54,86 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <assert.h>
+#include <time.h>
+
+//heap allocations of the test build, counted for --bench
+unsigned long alloc_cnt = 0;
+
+void *count_malloc(size_t size) {
+    __atomic_add_fetch(&alloc_cnt, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *count_calloc(size_t cnt, size_t size) {
+    __atomic_add_fetch(&alloc_cnt, 1, __ATOMIC_RELAXED);
+    return calloc(cnt, size);
+}
+
+void *count_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&alloc_cnt, 1, __ATOMIC_RELAXED);
+    return realloc(ptr, size);
+}
+
+#define malloc(size) count_malloc(size)
+#define calloc(cnt, size) count_calloc(cnt, size)
+#define realloc(ptr, size) count_realloc(ptr, size)
 
 #endif /* __PROGTEST__ */
 
+#if defined(__unix__) || defined(__APPLE__)
+#define WORDS_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(WORDS_THREADS) && !defined(__PROGTEST__)
+#include <errno.h>
+
+//pthread_create() of the test build fails once threads_left threads are created (-1 = never fails)
+int threads_left = -1;
+
+int limit_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start)(void *), void *arg) {
+    if (threads_left == 0) {
+        return EAGAIN;
+    }
+    if (threads_left > 0) {
+        threads_left--;
+    }
+
+    return pthread_create(thread, attr, start, arg);
+}
+
+#define pthread_create(thread, attr, start, arg) limit_pthread_create(thread, attr, start, arg)
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define FORMAT_SIMD
+#include <immintrin.h>
+#endif
+
 #define TRUE 1
 #define FALSE 0
 #define DELIM " "
 #define INIT_SIZE_ARR 32
 #define INIT_SIZE_STR 1
+#define SET_EMPTY -1
+#define ARENA_ALIGN 8
+#define FORMAT_CHUNK 4096
+#define GROUP_EMPTY -1
+#define MINHASH_EMPTY 0xFFFFFFFFFFFFFFFFULL
+#define FILE_CHUNK 65536
+#define FILE_ERROR -1
+#define INIT_SIZE_VOCAB 4096
+#define THREADS_MAX 64
+#define SORT_INSERTION 16
+#define TABLE_INLINE 20
+#define TABLE_EMPTY -1
+#define LIBRARY_EXACT 0
+#define LIBRARY_SUPERSET 1
+#define LIBRARY_SUBSET 2
+#define LIBRARY_REMOVED -1
+#define TRACKER_A 0
+#define TRACKER_B 1
 
 //dummy type for word_list
 typedef void *list_t;
@@ -30,6 +144,153 @@ typedef struct word_list {
     char **list;    //string array
 } word_list;
 
+//normalization kernel, @see format_chunk()
+typedef size_t (*format_fn)(char *dst, const char *src, size_t n, int *prev_space);
+
+//word stored in normalized buffer
+typedef struct word_span {
+    unsigned int offset;    //index of first char in normalized buffer
+    unsigned int length;    //number of chars
+} word_span;
+
+//bump allocator, all memory is freed at once
+typedef struct word_arena {
+    char *data;
+    size_t arena_size;      //total size
+    size_t arena_used;      //used size
+} word_arena;
+
+//word of a partition, @see sameWordsParallel()
+typedef struct word_entry {
+    unsigned int hash;      //word_hash() of word
+    word_span span;         //word in normalized text of its string
+} word_entry;
+
+//growable array of word_entry
+typedef struct word_bucket {
+    word_entry *entries;
+    int bucket_size;        //total size
+    int bucket_used;        //used size
+} word_bucket;
+
+//tokenizes one range of both strings, words are routed into buckets by hash
+typedef struct tokenize_job {
+    const char *raw[2];         //strings a, b
+    char *text[2];              //normalized strings, range is normalized in place of the same range
+    size_t start[2];            //range of a, b
+    size_t end[2];
+    int partitions;
+    word_bucket *buckets[2];    //partitions buckets for a, b
+} tokenize_job;
+
+//compares one partition of words of both strings
+typedef struct compare_job {
+    tokenize_job *jobs;
+    int jobs_cnt;
+    int partition;
+    int *mismatch;              //shared, set to TRUE by the first partition that differs
+} compare_job;
+
+//order and duplicate independent fingerprint of a word set
+typedef struct word_fingerprint {
+    unsigned long long low;     //sum of low halves of word hashes
+    unsigned long long high;    //sum of high halves of word hashes
+    int words;                  //number of unique words
+} word_fingerprint;
+
+//kernel used by format_chunk(), set once by format_init()
+format_fn format_chunk_impl = NULL;
+
+#ifdef WORDS_THREADS
+pthread_once_t format_once = PTHREAD_ONCE_INIT;
+#endif
+
+//format_shuffle[mask] = indexes of set bits of mask, then 0x80 (zero byte), for _mm_shuffle_epi8()
+unsigned char format_shuffle[256][8];
+
+typedef struct word_set {
+    int set_size;           //number of slots, power of 2
+    int set_used;           //number of words
+    const char *text;       //normalized buffer of words
+    word_span *spans;       //words in text
+    int *slots;             //index to spans, SET_EMPTY = empty slot
+    unsigned int *hashes;   //hash of word in slot
+    char *hits;             //TRUE if word was found in the other string
+} word_set;
+
+//slot of word_table, 32 bytes
+typedef struct table_entry {
+    unsigned int hash;          //word_hash() of word
+    unsigned int length;        //length of word
+    int id;                     //dense id of word, TABLE_EMPTY = empty slot
+    char word[TABLE_INLINE];    //word if length <= TABLE_INLINE, otherwise its offset (size_t) in pool
+} table_entry;
+
+//growable set of words that owns them, @see table_insert()
+typedef struct word_table {
+    table_entry *entries;   //slots, power of 2
+    int table_size;         //number of slots
+    int table_used;         //number of words, ids are 0 .. table_used - 1
+    char *pool;             //words longer than TABLE_INLINE one after another
+    size_t pool_size;       //total size of pool
+    size_t pool_used;       //used size of pool
+} word_table;
+
+//document in a posting list
+typedef struct word_posting {
+    int doc;                //document id
+    int term;               //index of the word in doc_terms of the document
+} word_posting;
+
+//documents containing one word, unordered
+typedef struct word_postings {
+    word_posting *docs;
+    int postings_size;      //total size
+    int postings_used;      //used size
+} word_postings;
+
+//word of a document
+typedef struct word_term {
+    int id;                 //word id, TABLE_EMPTY for the entry of a document without words
+    int slot;               //index of the document in the posting list of the word (or empty)
+} word_term;
+
+//inverted index of documents, @see library_query()
+typedef struct word_library {
+    word_table words;           //word -> word id, words of removed documents are dropped by library_compact()
+    word_postings *postings;    //indexed by word id
+    int postings_size;          //total size of postings (used size is table_size(&words))
+    word_postings empty;        //documents without words
+    int *doc_words;             //number of unique words of document, LIBRARY_REMOVED = removed document
+    word_term **doc_terms;      //words of document and its places in their posting lists
+    int *counts;                //query scratch, 0 for every document between queries
+    int docs_size;              //total size of doc_ arrays
+    int docs_used;              //used size, document ids are 0 .. docs_used - 1
+    int *free_docs;             //ids of removed documents, reused by library_add()
+    int free_used;              //used size of free_docs (total size is docs_size)
+    long terms;                 //words of stored documents, sum of doc_words
+    long removed_terms;         //words of documents removed since the last library_compact()
+} word_library;
+
+//word counts of two edited documents, @see tracker_same()
+typedef struct word_tracker {
+    word_table words;       //word -> word id
+    int *counts[2];         //occurrences of word id in document TRACKER_A, TRACKER_B
+    int counts_size;        //total size of counts (used size is table_size(&words))
+    int mismatch;           //number of words present in one document only
+} word_tracker;
+
+//reads normalized words from a file chunk by chunk
+typedef struct word_reader {
+    FILE *file;
+    char *buffer;           //normalized chars, words may continue into the next chunk
+    size_t buffer_size;     //total size
+    size_t pos;             //start of unread words
+    size_t end;             //end of normalized chars
+    int prev_space;         //@see format_chunk()
+    int eof;                //TRUE if the whole file was read
+} word_reader;
+
 /**
  * @param char* str
  * @return char*
@@ -102,170 +363,2901 @@ int compare(const void *a, const void *b);
  */
 void list_remove_duplicates(list_t in);
 
-int sameWords(const char *a, const char *b) {
-    //init lists, create copies of const inputs
-    //a_list, b_list, a_copy, b_copy are dynamically allocated -> MUST BE FREED
-    list_t a_list = init_list();
-    list_t b_list = init_list();
-    char *a_copy = get_copy(a);
-    char *b_copy = get_copy(b);
+/**
+ * @param char* dst
+ * @param const char* src
+ * @param size_t n
+ * @param int* prev_space
+ * @return size_t
+ *
+ * normalize n chars of src into dst by str_format() rules - keep letters (lowercased) and whitespace that follows
+ * non-whitespace, prev_space is TRUE if the char before src was whitespace (or src is the start of string), it is
+ * updated to the last char of src, return number of chars written
+ * dst may be src (in place), uses the fastest kernel available (@see format_init())
+ */
+size_t format_chunk(char *dst, const char *src, size_t n, int *prev_space);
 
-    //correct format, parse words into lists
-    str_format(a_copy);
-    str_format(b_copy);
-    parse_words(a_list, a_copy);
-    parse_words(b_list, b_copy);
+/**
+ * @see format_chunk(), reference kernel, one char at a time
+ */
+size_t format_chunk_scalar(char *dst, const char *src, size_t n, int *prev_space);
 
-    //compare lists
-    int cmp = list_compare(a_list, b_list);
+#ifdef FORMAT_SIMD
+/**
+ * @see format_chunk(), classifies 16 chars at a time, kept chars are packed by keep mask bit by bit
+ */
+size_t format_chunk_sse2(char *dst, const char *src, size_t n, int *prev_space);
 
-    //free dynamic arrays
-    free(a_copy);
-    free(b_copy);
-    free_list(a_list);
-    free_list(b_list);
-    return cmp;
-}
+/**
+ * @see format_chunk(), classifies 32 chars at a time, kept chars are packed 8 at a time by format_shuffle table
+ */
+size_t format_chunk_avx2(char *dst, const char *src, size_t n, int *prev_space);
+#endif
 
-char *get_copy(const char *str) {
-    size_t size = strlen(str);
-    char *copy = (char *) calloc(size, sizeof(char));
-    for (size_t i = 0; i < size; i++) {
-        copy[i] = str[i];
-    }
+/**
+ * select format_chunk() kernel by CPU features, runs only once (pthread_once() where threads are available,
+ * otherwise the first call must not race with other threads), called by every format_chunk()
+ */
+void format_init();
 
-    return copy;
-}
+/**
+ * @see format_init(), does the selection
+ */
+void format_select();
 
-void str_format(char *str) {
-    int i, j;
+/**
+ * @param const char* text
+ * @param size_t* pos
+ * @param size_t end
+ * @param int last
+ * @param word_span* span
+ * @return int (TRUE|FALSE)
+ *
+ * find next word (separated by DELIM) of normalized text between pos and end, pos is moved after the word
+ * unless last is TRUE the word must be followed by DELIM (it may continue after end), return FALSE if no word is found
+ */
+int next_span(const char *text, size_t *pos, size_t end, int last, word_span *span);
 
-    //remove extra whitespaces and lowercase all characters
-    for (i = j = 0; str[i]; ++i) {
-        if ((!isspace(str[i]) || (i > 0 && !isspace(str[i - 1]))) && (isalpha(str[i]) || isspace(str[i]))) {
-            str[j++] = tolower(str[i]);
-        }
-    }
+/**
+ * @param const char* word
+ * @param int len
+ * @return unsigned int
+ *
+ * FNV-1a hash of word
+ */
+unsigned int word_hash(const char *word, int len);
 
-    str[j] = '\0';
-}
+/**
+ * @param const char* str
+ * @param size_t len
+ * @param char* text
+ * @param word_span* spans
+ * @return int
+ *
+ * normalize str of length len into text (@see format_chunk()) and split it into words, their positions are stored
+ * in spans, return number of words
+ * text must have room for len chars, spans for len / 2 + 1 words
+ */
+int tokenize(const char *str, size_t len, char *text, word_span *spans);
 
-list_t init_list() {
-    word_list *wlist = (word_list *) malloc(sizeof(word_list));
-    wlist->list_size = INIT_SIZE_ARR;
-    wlist->list_used = 0;
-    wlist->list = (char **) calloc(INIT_SIZE_ARR, sizeof(char *));
+/**
+ * @param word_arena* arena
+ * @param size_t size
+ *
+ * allocate arena of size bytes
+ */
+void arena_init(word_arena *arena, size_t size);
 
-    for (int i = 0; i < INIT_SIZE_ARR; i++) {
-        wlist->list[i] = (char *) calloc(INIT_SIZE_STR, sizeof(char));
-    }
+/**
+ * @param word_arena* arena
+ * @param size_t size
+ * @return void*
+ *
+ * return next size bytes of arena (aligned to ARENA_ALIGN), arena must be large enough
+ */
+void *arena_alloc(word_arena *arena, size_t size);
 
-    return wlist;
-}
+/**
+ * @param word_arena* arena
+ *
+ * free all memory of arena
+ */
+void arena_free(word_arena *arena);
 
-void free_list(list_t in) {
-    word_list *wlist = (word_list *) in;
-    for (int i = 0; i < wlist->list_size; i++) {
-        free(wlist->list[i]);
-    }
+/**
+ * @param int words
+ * @return int
+ *
+ * number of slots of word_set for words words (power of 2, at least twice the number of words)
+ */
+int set_slots_for(int words);
 
-    free(wlist->list);
-    free(wlist);
-}
+/**
+ * @param word_set* set
+ * @param word_arena* arena
+ * @param int size
+ * @param const char* text
+ * @param word_span* spans
+ *
+ * create empty word_set with size slots (@see set_slots_for()) in arena over words in text
+ */
+void set_init(word_set *set, word_arena *arena, int size, const char *text, word_span *spans);
 
-void list_resize(list_t in, int new_size) {
-    word_list *wlist = (word_list *) in;
-    wlist->list_size = new_size;
-    wlist->list = (char **) realloc(wlist->list, wlist->list_size * sizeof(char *));
-    for (int i = wlist->list_used; i < wlist->list_size; i++) {
-        wlist->list[i] = (char *) calloc(INIT_SIZE_STR, sizeof(char));
-    }
-}
+/**
+ * @param word_set* set
+ * @param const char* word
+ * @param int len
+ * @param unsigned int hash
+ * @return int
+ *
+ * return slot of word in set, or the empty slot where it belongs
+ */
+int set_slot(word_set *set, const char *word, int len, unsigned int hash);
 
-void parse_words(list_t in, char *str) {
-    word_list *wlist = (word_list *) in;
-    char *parsed = strtok(str, DELIM); //get first word from str
+/**
+ * @param word_set* set
+ * @param int span
+ * @return int (TRUE|FALSE)
+ *
+ * add word spans[span] to set if not present, return TRUE if it was added
+ */
+int set_insert(word_set *set, int span);
 
-    int index = 0;
+/**
+ * @param const char* word
+ * @param int len
+ * @param unsigned long long* low
+ * @param unsigned long long* high
+ *
+ * 128-bit MurmurHash3 (x64 variant, seed 0) of word, returned as low and high half
+ */
+void word_hash128(const char *word, int len, unsigned long long *low, unsigned long long *high);
 
-    while (parsed != NULL) { //str is empty if parsed == NULL
-        if (wlist->list_size == wlist->list_used) {
-            list_resize(in, 2 * wlist->list_size);
-        }
+/**
+ * @param unsigned long long k
+ * @return unsigned long long
+ *
+ * MurmurHash3 64-bit finalizer, mixes all bits of k
+ */
+unsigned long long fmix64(unsigned long long k);
 
-        wlist->list[index] = (char *) realloc(wlist->list[index],
-                                              strlen(parsed) + 1); //change size of list[index] to size of parsed
-        strcpy(wlist->list[index], parsed);
+/**
+ * @param const char* a
+ * @param const char* b
+ * @return int (TRUE|FALSE)
+ *
+ * original method of sameWords() - sort both word lists, remove duplicates and compare them
+ */
+int sameWordsSorted(const char *a, const char *b);
 
-        index++;
-        wlist->list_used++;
-        parsed = strtok(NULL, DELIM); //get next word from original string
-    }
-}
+/**
+ * @param const char* str
+ * @param word_arena* arena
+ * @param char** text
+ * @param word_span** spans
+ * @return int
+ *
+ * normalize and split str into text and spans allocated in arena (arena is initialized here -> MUST BE FREED),
+ * duplicate words are removed from spans, return number of unique words
+ */
+int tokenize_unique(const char *str, word_arena *arena, char **text, word_span **spans);
 
-int list_compare(list_t a, list_t b) {
-    word_list *wlist_a = (word_list *) a;
-    word_list *wlist_b = (word_list *) b;
+/**
+ * @param const char* str
+ * @return word_fingerprint
+ *
+ * fingerprint of the set of words of str, strings with the same words (sameWords() == TRUE) have equal fingerprints,
+ * different word sets collide with probability about 2^-128
+ */
+word_fingerprint sameWordsFingerprint(const char *str);
 
+/**
+ * @param const char** docs
+ * @param int docs_cnt
+ * @param int* groups
+ * @return int
+ *
+ * group docs with the same words, groups[i] = index of the first document with the same words as docs[i],
+ * documents are bucketed by fingerprint and compared by sameWords() only within a bucket, return number of groups
+ */
+int sameWordsGroups(const char **docs, int docs_cnt, int *groups);
 
-    //sort both lists alphabetically
-    qsort(wlist_a->list, wlist_a->list_used, sizeof wlist_a->list[0], compare);
-    qsort(wlist_b->list, wlist_b->list_used, sizeof wlist_b->list[0], compare);
+/**
+ * @param const char* str
+ * @param int hashes_cnt
+ * @param unsigned long long* signature
+ *
+ * MinHash signature of the set of words of str, signature[i] = minimum of i-th hash function over unique words
+ * (MINHASH_EMPTY if str has no words), signature must have room for hashes_cnt values
+ * longer signature = more accurate sameWordsSimilarity() (error about 1 / sqrt(hashes_cnt)), slower to compute
+ */
+void sameWordsMinHash(const char *str, int hashes_cnt, unsigned long long *signature);
 
-    //remove duplicates from lists
-    list_remove_duplicates(a);
-    list_remove_duplicates(b);
+/**
+ * @param const unsigned long long* a
+ * @param const unsigned long long* b
+ * @param int hashes_cnt
+ * @return double
+ *
+ * estimated Jaccard similarity (|A & B| / |A | B|) of word sets with signatures a and b (@see sameWordsMinHash())
+ */
+double sameWordsSimilarity(const unsigned long long *a, const unsigned long long *b, int hashes_cnt);
 
-    //false is used sizes differ
-    if (wlist_a->list_used != wlist_b->list_used) {
-        return FALSE;
-    }
+/**
+ * @param const unsigned long long* signatures
+ * @param int docs_cnt
+ * @param int hashes_cnt
+ * @param int bands
+ * @param int* pairs_cnt
+ * @return int*
+ *
+ * find candidate pairs of similar documents by LSH banding, signatures of docs_cnt documents are stored one after
+ * another (docs_cnt * hashes_cnt values), each signature is split into bands of hashes_cnt / bands rows and documents
+ * with an identical band become a candidate pair
+ * a pair with similarity s is found with probability 1 - (1 - s^rows)^bands, ex. 128 hashes in 16 bands of 8 rows
+ * find 99.99% of pairs with s = 0.9 and 6% of pairs with s = 0.5, candidates should be verified by
+ * sameWordsSimilarity() or sameWords()
+ * a pair is kept only in the first band it shares, so memory is O(unique pairs) however many bands match
+ * return array of 2 * pairs_cnt document indexes (pairs i < j, sorted, without duplicates) -> MUST BE FREED,
+ * NULL (pairs_cnt = 0) if memory runs out
+ */
+int *sameWordsCandidates(const unsigned long long *signatures, int docs_cnt, int hashes_cnt, int bands,
+                         int *pairs_cnt);
 
-    //iterate over list_a and compare contents to list_b, false if mismatch is found
-    for (int i = 0; i < wlist_a->list_used; i++) {
-        if (strcmp(wlist_a->list[i], wlist_b->list[i])) {
-            return FALSE;
-        }
-    }
+/**
+ * @param const unsigned long long* signatures
+ * @param int hashes_cnt
+ * @param int rows
+ * @param int band
+ * @param int a
+ * @param int b
+ * @return int (TRUE|FALSE)
+ *
+ * TRUE if documents a and b have identical rows in a band before band, the pair was found there already
+ */
+int candidates_found_before(const unsigned long long *signatures, int hashes_cnt, int rows, int band, int a, int b);
 
-    //lists match
-    return TRUE;
-}
+/**
+ * @param const void* a
+ * @param const void* b
+ * @return int
+ *
+ * compare function for candidate pairs (two ints)
+ */
+int compare_pairs(const void *a, const void *b);
 
-int compare(const void *a, const void *b) {
-    char **ch_a = (char **) a;
-    char **ch_b = (char **) b;
+/**
+ * @param const char* path_a
+ * @param const char* path_b
+ * @return int (TRUE|FALSE|FILE_ERROR)
+ *
+ * sameWords() of contents of files path_a and path_b, FILE_ERROR if a file can't be read
+ */
+int sameWordsFiles(const char *path_a, const char *path_b);
 
-    return strcmp(*ch_a, *ch_b);
-}
+/**
+ * @param FILE* a
+ * @param FILE* b
+ * @return int (TRUE|FALSE|FILE_ERROR)
+ *
+ * @see sameWordsFiles(), words of a are kept in word_table, words of b are looked up as they are read,
+ * first word of b not present in a ends the comparison
+ */
+int sameWordsStreams(FILE *a, FILE *b);
 
-void list_remove_duplicates(list_t in) {
-    word_list *wlist = (word_list *) in;
-    int i, j;
-    int n = wlist->list_used;
+/**
+ * @param word_reader* reader
+ * @param FILE* file
+ *
+ * create reader of file
+ */
+void reader_init(word_reader *reader, FILE *file);
 
+/**
+ * @param word_reader* reader
+ *
+ * free memory allocated by reader, file is not closed
+ */
+void reader_free(word_reader *reader);
 
-    //iterate over sorted list and remove duplicates
-    for (i = j = 0; i < n; i++) {
-        if (strcmp(wlist->list[i], wlist->list[i + 1])) {
-            wlist->list[j] = (char *) realloc(wlist->list[j], strlen(wlist->list[i]) + 1);
-            strcpy(wlist->list[j], wlist->list[i]);
+/**
+ * @param word_reader* reader
+ * @param word_span* span
+ * @return int (TRUE|FALSE)
+ *
+ * read next word into span (offset into reader->buffer, valid until the next call), FALSE at end of file
+ */
+int reader_next(word_reader *reader, word_span *span);
+
+/**
+ * @param word_table* table
+ * @param int words
+ *
+ * create empty word_table with room for words words before it grows
+ */
+void table_init(word_table *table, int words);
+
+/**
+ * @param word_table* table
+ *
+ * free memory allocated by table
+ */
+void table_free(word_table *table);
+
+/**
+ * @param word_table* table
+ *
+ * remove all words, memory is kept for reuse
+ */
+void table_clear(word_table *table);
+
+/**
+ * @param const word_table* table
+ * @param const table_entry* entry
+ * @return const char*
+ *
+ * chars of word in entry (not null-terminated, entry->length chars), valid until the next table_insert()
+ */
+const char *table_text(const word_table *table, const table_entry *entry);
+
+/**
+ * @param const word_table* table
+ * @param const char* word
+ * @param int len
+ * @param unsigned int hash
+ * @return int
+ *
+ * return slot of word (hash = word_hash() of word) in table, or the empty slot where it belongs
+ */
+int table_slot(const word_table *table, const char *word, int len, unsigned int hash);
+
+/**
+ * @param word_table* table
+ * @param const char* word
+ * @param int len
+ * @return int
+ *
+ * add word to table if not present, return its id - new words get id table_size() - 1
+ * slots are doubled when more than half are used
+ */
+int table_insert(word_table *table, const char *word, int len);
+
+/**
+ * @param const word_table* table
+ * @param const char* word
+ * @param int len
+ * @return int
+ *
+ * return id of word, TABLE_EMPTY if table does not contain it
+ */
+int table_lookup(const word_table *table, const char *word, int len);
+
+/**
+ * @param const word_table* table
+ * @param const char* word
+ * @param int len
+ * @return int (TRUE|FALSE)
+ */
+int table_contains(const word_table *table, const char *word, int len);
+
+/**
+ * @param const word_table* table
+ * @return int
+ *
+ * number of words in table, word ids are 0 .. table_size() - 1
+ */
+int table_size(const word_table *table);
+
+/**
+ * @param const word_table* table
+ * @param int* pos
+ * @return const table_entry*
+ *
+ * iterate over words of table in slot order, *pos is 0 before the first call, return NULL after the last word
+ */
+const table_entry *table_next(const word_table *table, int *pos);
+
+/**
+ * @param word_library* library
+ *
+ * create empty word_library
+ */
+void library_init(word_library *library);
+
+/**
+ * @param word_library* library
+ *
+ * free memory allocated by library
+ */
+void library_free(word_library *library);
+
+/**
+ * @param word_library* library
+ * @param const char* str
+ * @return int
+ *
+ * add document str to library, return its id (the id of a removed document is reused)
+ */
+int library_add(word_library *library, const char *str);
+
+/**
+ * @param word_library* library
+ * @param int doc
+ * @return int (TRUE|FALSE)
+ *
+ * remove document doc from library, FALSE if there is no such document
+ * time of its words (every word knows its place in the posting list), plus library_compact() once more words were
+ * removed than are stored, so amortized time of its words too
+ */
+int library_remove(word_library *library, int doc);
+
+/**
+ * @param word_library* library
+ *
+ * rebuild words of library without words that are in no document (new word ids), time of words and postings
+ */
+void library_compact(word_library *library);
+
+/**
+ * @param word_library* library
+ * @param const char* str
+ * @param int mode
+ * @param int* docs_cnt
+ * @return int*
+ *
+ * find documents whose words are (mode) LIBRARY_EXACT - the words of str (sameWords() == TRUE),
+ * LIBRARY_SUPERSET - at least the words of str, LIBRARY_SUBSET - only words of str
+ * time of postings of words of str (LIBRARY_SUPERSET of a string without words returns all documents)
+ * return array of docs_cnt sorted document ids -> MUST BE FREED
+ */
+int *library_query(word_library *library, const char *str, int mode, int *docs_cnt);
+
+/**
+ * @param word_tracker* tracker
+ * @param const char* a
+ * @param const char* b
+ *
+ * create word_tracker of documents a, b
+ */
+void tracker_init(word_tracker *tracker, const char *a, const char *b);
+
+/**
+ * @param word_tracker* tracker
+ *
+ * free memory allocated by tracker
+ */
+void tracker_free(word_tracker *tracker);
+
+/**
+ * @param const word_tracker* tracker
+ * @return int (TRUE|FALSE)
+ *
+ * sameWords() of the documents in their current state, O(1)
+ */
+int tracker_same(const word_tracker *tracker);
+
+/**
+ * @param word_tracker* tracker
+ * @param int doc
+ * @param const char* str
+ * @return int (TRUE|FALSE)
+ *
+ * words of str were added to document doc (TRACKER_A|TRACKER_B)
+ */
+int tracker_insert(word_tracker *tracker, int doc, const char *str);
+
+/**
+ * @param word_tracker* tracker
+ * @param int doc
+ * @param const char* str
+ * @return int (TRUE|FALSE)
+ *
+ * words of str were deleted from document doc, FALSE (and nothing changes) if doc does not have them
+ */
+int tracker_delete(word_tracker *tracker, int doc, const char *str);
+
+/**
+ * @param word_tracker* tracker
+ * @param int doc
+ * @param const char* text
+ * @param size_t text_len
+ * @param size_t start
+ * @param size_t end
+ * @param const char* replacement
+ * @return int (TRUE|FALSE)
+ *
+ * chars start .. end - 1 of document doc (text of text_len chars, as the tracker knows it) are replaced by
+ * replacement, only words around the range are tokenized again, text itself is not changed
+ * FALSE (and nothing changes) if start > end, end > text_len, or a word around the range is not counted in doc -
+ * text is not compared to the document, an edit of other text with the same words there is applied
+ */
+int tracker_replace(word_tracker *tracker, int doc, const char *text, size_t text_len, size_t start, size_t end,
+                    const char *replacement);
+
+/**
+ * @param word_tracker* tracker
+ * @param int doc
+ * @param const char* str
+ * @param size_t len
+ * @param int delta
+ * @return int (TRUE|FALSE)
+ *
+ * add delta to counts of words of str (len chars, starts at a word boundary) in document doc,
+ * FALSE (and nothing changes) if a count would be negative
+ */
+int tracker_apply(word_tracker *tracker, int doc, const char *str, size_t len, int delta);
+
+/**
+ * @param word_postings* postings
+ * @param int doc
+ * @param int term
+ * @return int
+ *
+ * append doc (term = index of the word in doc_terms of doc) to postings, return its slot
+ */
+int postings_add(word_postings *postings, int doc, int term);
+
+/**
+ * @param word_library* library
+ * @param word_postings* postings
+ * @param int slot
+ *
+ * remove the document in slot of postings, the last document takes its place and its word_term is updated
+ */
+void postings_remove(word_library *library, word_postings *postings, int slot);
+
+/**
+ * @param const void* a
+ * @param const void* b
+ * @return int
+ *
+ * compare function for ints
+ */
+int compare_ints(const void *a, const void *b);
+
+/**
+ * @param const char* a
+ * @param const char* b
+ * @param int threads_cnt
+ * @return int (TRUE|FALSE)
+ *
+ * sameWords() on threads_cnt threads (0 = number of CPUs, at most THREADS_MAX), same result as sameWords()
+ * a job whose thread can't be created runs on the calling thread, without thread support it is sameWords()
+ */
+int sameWordsParallel(const char *a, const char *b, int threads_cnt);
+
+/**
+ * @param const char* a
+ * @param const char* b
+ * @return int (TRUE|FALSE)
+ *
+ * same result as sameWords(), compares sorted vocabularies of a and b (@see tokenize_sorted())
+ */
+int sameWordsRadix(const char *a, const char *b);
+
+/**
+ * @param const char* str
+ * @param word_arena* arena
+ * @param char** text
+ * @param word_span** spans
+ * @return int
+ *
+ * normalize and split str into text and spans allocated in arena (arena is initialized here -> MUST BE FREED),
+ * spans are sorted (bytewise, as strcmp()) without duplicates, return number of unique words
+ */
+int tokenize_sorted(const char *str, word_arena *arena, char **text, word_span **spans);
+
+/**
+ * @param const char* text
+ * @param word_span span
+ * @param unsigned int depth
+ * @return int
+ *
+ * char of word span at depth, 0 past the end of word (words never contain 0)
+ */
+int span_char(const char *text, word_span span, unsigned int depth);
+
+/**
+ * @param const char* text
+ * @param word_span a
+ * @param word_span b
+ * @param unsigned int depth
+ * @return int
+ *
+ * compare words a, b from depth on (first depth chars are equal), strcmp() result
+ */
+int span_compare(const char *text, word_span a, word_span b, unsigned int depth);
+
+/**
+ * @param const char* text
+ * @param word_span* spans
+ * @param int n
+ * @param unsigned int depth
+ * @param word_span* out
+ * @return int
+ *
+ * multikey quicksort of n spans with equal first depth chars, unique words are written to out in sorted order,
+ * return their number
+ * out may be spans (in place) - it never gets ahead of the part being sorted
+ */
+int span_sort(const char *text, word_span *spans, int n, unsigned int depth, word_span *out);
+
+/**
+ * @param const char* str
+ * @param size_t len
+ * @param size_t from
+ * @return size_t
+ *
+ * first position at or after from where a word of str can start - after a space that separates words
+ * (@see str_format()), len if there is none
+ */
+size_t word_boundary(const char *str, size_t len, size_t from);
+
+/**
+ * @param void* arg
+ * @return void*
+ *
+ * tokenize ranges of tokenize_job (arg) into buckets
+ */
+void *tokenize_worker(void *arg);
+
+/**
+ * @param void* arg
+ * @return void*
+ *
+ * compare one partition of compare_job (arg), set mismatch if words differ
+ */
+void *compare_worker(void *arg);
+
+int sameWords(const char *a, const char *b) {
+    size_t a_len = strlen(a);
+    size_t b_len = strlen(b);
+    int max_words = (int) (a_len / 2 + 1);
+
+    //everything lives in one arena -> MUST BE FREED
+    word_arena arena;
+    arena_init(&arena, (a_len + 1) + max_words * sizeof(word_span) + (b_len + 1) +
+                       set_slots_for(max_words) * (sizeof(int) + sizeof(unsigned int) + sizeof(char)) +
+                       6 * ARENA_ALIGN);
+
+    //normalize and split a, only used part of spans is kept
+    char *a_text = (char *) arena_alloc(&arena, a_len + 1);
+    word_span *a_spans = (word_span *) arena_alloc(&arena, max_words * sizeof(word_span));
+    int a_cnt = tokenize(a, a_len, a_text, a_spans);
+    arena.arena_used -= (max_words - a_cnt) * sizeof(word_span);
+
+    char *b_text = (char *) arena_alloc(&arena, b_len + 1);
+    word_set set;
+    set_init(&set, &arena, set_slots_for(a_cnt), a_text, a_spans);
+
+    //insert all words of a
+    for (int i = 0; i < a_cnt; i++) {
+        set_insert(&set, i);
+    }
+
+    //normalize b chunk by chunk and look up its words, false on first word not present in a
+    int cmp = TRUE;
+    int hits = 0;
+    int b_prev_space = TRUE;
+    size_t b_read = 0;
+    size_t b_end = 0;
+    size_t b_pos = 0;
+    word_span span;
+
+    do {
+        size_t chunk = b_len - b_read < FORMAT_CHUNK ? b_len - b_read : FORMAT_CHUNK;
+        b_end += format_chunk(b_text + b_end, b + b_read, chunk, &b_prev_space);
+        b_read += chunk;
+
+        //the last word of a chunk may continue in the next one
+        while (cmp && next_span(b_text, &b_pos, b_end, b_read == b_len, &span)) {
+            const char *word = b_text + span.offset;
+            int slot = set_slot(&set, word, (int) span.length, word_hash(word, (int) span.length));
+
+            if (set.slots[slot] == SET_EMPTY) {
+                cmp = FALSE;
+            } else if (!set.hits[slot]) {
+                set.hits[slot] = TRUE;
+                hits++;
+            }
+        }
+    } while (cmp && b_read < b_len);
+
+    //every word of a must have been found in b
+    if (hits != set.set_used) {
+        cmp = FALSE;
+    }
+
+    arena_free(&arena);
+    return cmp;
+}
+
+int sameWordsSorted(const char *a, const char *b) {
+    //init lists, create copies of const inputs
+    //a_list, b_list, a_copy, b_copy are dynamically allocated -> MUST BE FREED
+    list_t a_list = init_list();
+    list_t b_list = init_list();
+    char *a_copy = get_copy(a);
+    char *b_copy = get_copy(b);
+
+    //correct format, parse words into lists
+    str_format(a_copy);
+    str_format(b_copy);
+    parse_words(a_list, a_copy);
+    parse_words(b_list, b_copy);
+
+    //compare lists
+    int cmp = list_compare(a_list, b_list);
+
+    //free dynamic arrays
+    free(a_copy);
+    free(b_copy);
+    free_list(a_list);
+    free_list(b_list);
+    return cmp;
+}
+
+int tokenize_unique(const char *str, word_arena *arena, char **text, word_span **spans) {
+    size_t len = strlen(str);
+    int max_words = (int) (len / 2 + 1);
+
+    arena_init(arena, (len + 1) + max_words * sizeof(word_span) +
+                      set_slots_for(max_words) * (sizeof(int) + sizeof(unsigned int) + sizeof(char)) +
+                      5 * ARENA_ALIGN);
+
+    *text = (char *) arena_alloc(arena, len + 1);
+    *spans = (word_span *) arena_alloc(arena, max_words * sizeof(word_span));
+    int cnt = tokenize(str, len, *text, *spans);
+    arena->arena_used -= (max_words - cnt) * sizeof(word_span);
+
+    word_set set;
+    set_init(&set, arena, set_slots_for(cnt), *text, *spans);
+
+    //move unique words to the front of spans, the set only refers to spans already moved
+    int unique = 0;
+    for (int i = 0; i < cnt; i++) {
+        const char *word = *text + (*spans)[i].offset;
+        unsigned int hash = word_hash(word, (int) (*spans)[i].length);
+        int slot = set_slot(&set, word, (int) (*spans)[i].length, hash);
+
+        if (set.slots[slot] == SET_EMPTY) {
+            (*spans)[unique] = (*spans)[i];
+            set.slots[slot] = unique++;
+            set.hashes[slot] = hash;
+            set.set_used++;
+        }
+    }
+
+    return unique;
+}
+
+word_fingerprint sameWordsFingerprint(const char *str) {
+    word_fingerprint fingerprint = {0, 0, 0};
+    word_arena arena;
+    char *text;
+    word_span *spans;
+    int cnt = tokenize_unique(str, &arena, &text, &spans);
+
+    //sum is order independent, duplicates were removed
+    for (int i = 0; i < cnt; i++) {
+        unsigned long long low, high;
+        word_hash128(text + spans[i].offset, (int) spans[i].length, &low, &high);
+
+        fingerprint.low += low;
+        fingerprint.high += high;
+    }
+    fingerprint.words = cnt;
+
+    arena_free(&arena);
+    return fingerprint;
+}
+
+int sameWordsGroups(const char **docs, int docs_cnt, int *groups) {
+    int size = set_slots_for(docs_cnt);
+    int mask = size - 1;
+    int groups_cnt = 0;
+
+    //slots hold the first document of each group, fingerprints of all documents are kept
+    //slots, fingerprints are dynamically allocated -> MUST BE FREED
+    int *slots = (int *) malloc(size * sizeof(int));
+    word_fingerprint *fingerprints = (word_fingerprint *) malloc((docs_cnt > 0 ? docs_cnt : 1) *
+                                                                 sizeof(word_fingerprint));
+
+    for (int i = 0; i < size; i++) {
+        slots[i] = GROUP_EMPTY;
+    }
+
+    for (int i = 0; i < docs_cnt; i++) {
+        fingerprints[i] = sameWordsFingerprint(docs[i]);
+        int slot = (int) (fingerprints[i].low & (unsigned long long) mask);
+
+        //linear probing, groups with the same fingerprint are verified, different word sets with the same
+        //fingerprint get separate slots
+        groups[i] = GROUP_EMPTY;
+        while (slots[slot] != GROUP_EMPTY) {
+            word_fingerprint *first = &fingerprints[slots[slot]];
+
+            if (first->low == fingerprints[i].low && first->high == fingerprints[i].high &&
+                first->words == fingerprints[i].words && sameWords(docs[slots[slot]], docs[i])) {
+                groups[i] = slots[slot];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        if (groups[i] == GROUP_EMPTY) {
+            slots[slot] = i;
+            groups[i] = i;
+            groups_cnt++;
+        }
+    }
+
+    free(slots);
+    free(fingerprints);
+    return groups_cnt;
+}
+
+void sameWordsMinHash(const char *str, int hashes_cnt, unsigned long long *signature) {
+    word_arena arena;
+    char *text;
+    word_span *spans;
+    int cnt = tokenize_unique(str, &arena, &text, &spans);
+
+    for (int h = 0; h < hashes_cnt; h++) {
+        signature[h] = MINHASH_EMPTY;
+    }
+
+    //i-th hash function = mixed (low + i * high) of the 128-bit word hash
+    for (int i = 0; i < cnt; i++) {
+        unsigned long long low, high;
+        word_hash128(text + spans[i].offset, (int) spans[i].length, &low, &high);
+
+        for (int h = 0; h < hashes_cnt; h++) {
+            unsigned long long value = fmix64(low + (unsigned long long) h * high);
+
+            if (value < signature[h]) {
+                signature[h] = value;
+            }
+        }
+    }
+
+    arena_free(&arena);
+}
+
+double sameWordsSimilarity(const unsigned long long *a, const unsigned long long *b, int hashes_cnt) {
+    int same = 0;
+
+    for (int h = 0; h < hashes_cnt; h++) {
+        if (a[h] == b[h]) {
+            same++;
+        }
+    }
+
+    return hashes_cnt > 0 ? (double) same / hashes_cnt : 0.0;
+}
+
+int *sameWordsCandidates(const unsigned long long *signatures, int docs_cnt, int hashes_cnt, int bands,
+                         int *pairs_cnt) {
+    int rows = bands > 0 ? hashes_cnt / bands : 0;
+    int size = set_slots_for(docs_cnt);
+    int mask = size - 1;
+    int pairs_size = INIT_SIZE_ARR;
+
+    //slots hold the first document of a bucket, next links documents of the same bucket
+    //slots, next, band_hashes, pairs are dynamically allocated -> MUST BE FREED (pairs by caller)
+    int *slots = (int *) malloc(size * sizeof(int));
+    int *next = (int *) malloc((docs_cnt > 0 ? docs_cnt : 1) * sizeof(int));
+    unsigned long long *band_hashes = (unsigned long long *) malloc(size * sizeof(unsigned long long));
+    int *pairs = (int *) malloc(2 * pairs_size * sizeof(int));
+
+    *pairs_cnt = 0;
+    if (slots == NULL || next == NULL || band_hashes == NULL || pairs == NULL) {
+        bands = 0;
+        free(pairs);
+        pairs = NULL;
+    }
+
+    for (int band = 0; band < bands && rows > 0; band++) {
+        int first_row = band * rows;
+
+        for (int i = 0; i < size; i++) {
+            slots[i] = GROUP_EMPTY;
+        }
+
+        for (int doc = 0; doc < docs_cnt; doc++) {
+            const unsigned long long *band_rows = signatures + (size_t) doc * hashes_cnt + first_row;
+            unsigned long long hash = (unsigned long long) band;
+
+            for (int r = 0; r < rows; r++) {
+                hash = fmix64(hash ^ band_rows[r]);
+            }
+
+            //find bucket with identical rows (different rows with the same hash get separate buckets)
+            int slot = (int) (hash & (unsigned long long) mask);
+            while (slots[slot] != GROUP_EMPTY &&
+                   (band_hashes[slot] != hash ||
+                    memcmp(signatures + (size_t) slots[slot] * hashes_cnt + first_row, band_rows,
+                           rows * sizeof(unsigned long long)) != 0)) {
+                slot = (slot + 1) & mask;
+            }
+
+            //every document already in the bucket forms a pair with doc, unless an earlier band found it
+            for (int other = slots[slot]; other != GROUP_EMPTY && pairs != NULL; other = next[other]) {
+                if (candidates_found_before(signatures, hashes_cnt, rows, band, other, doc)) {
+                    continue;
+                }
+
+                if (*pairs_cnt == pairs_size) {
+                    int *grown = (int *) realloc(pairs, 4 * pairs_size * sizeof(int));
+
+                    if (grown == NULL) {
+                        free(pairs);
+                        pairs = NULL;
+                        *pairs_cnt = 0;
+                        bands = 0;
+                        break;
+                    }
+                    pairs = grown;
+                    pairs_size *= 2;
+                }
+
+                pairs[2 * *pairs_cnt] = other;
+                pairs[2 * *pairs_cnt + 1] = doc;
+                (*pairs_cnt)++;
+            }
+
+            next[doc] = slots[slot];
+            slots[slot] = doc;
+            band_hashes[slot] = hash;
+        }
+    }
+
+    if (pairs != NULL) {
+        qsort(pairs, *pairs_cnt, 2 * sizeof(int), compare_pairs);
+    }
+
+    free(slots);
+    free(next);
+    free(band_hashes);
+    return pairs;
+}
+
+int candidates_found_before(const unsigned long long *signatures, int hashes_cnt, int rows, int band, int a, int b) {
+    const unsigned long long *rows_a = signatures + (size_t) a * hashes_cnt;
+    const unsigned long long *rows_b = signatures + (size_t) b * hashes_cnt;
+
+    for (int earlier = 0; earlier < band; earlier++) {
+        if (memcmp(rows_a + earlier * rows, rows_b + earlier * rows, rows * sizeof(unsigned long long)) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+int compare_pairs(const void *a, const void *b) {
+    const int *pair_a = (const int *) a;
+    const int *pair_b = (const int *) b;
+
+    if (pair_a[0] != pair_b[0]) {
+        return pair_a[0] < pair_b[0] ? -1 : 1;
+    }
+    if (pair_a[1] != pair_b[1]) {
+        return pair_a[1] < pair_b[1] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+int sameWordsFiles(const char *path_a, const char *path_b) {
+    FILE *a = fopen(path_a, "rb");
+    FILE *b = fopen(path_b, "rb");
+    int cmp = FILE_ERROR;
+
+    if (a != NULL && b != NULL) {
+        cmp = sameWordsStreams(a, b);
+    }
+
+    if (a != NULL) {
+        fclose(a);
+    }
+    if (b != NULL) {
+        fclose(b);
+    }
+    return cmp;
+}
+
+int sameWordsStreams(FILE *a, FILE *b) {
+    word_reader reader;
+    word_table table;
+    word_span span;
+
+    //table, reader, hits are dynamically allocated -> MUST BE FREED
+    table_init(&table, INIT_SIZE_VOCAB);
+
+    //insert all words of a
+    reader_init(&reader, a);
+    while (reader_next(&reader, &span)) {
+        table_insert(&table, reader.buffer + span.offset, (int) span.length);
+    }
+    reader_free(&reader);
+
+    if (ferror(a)) {
+        table_free(&table);
+        return FILE_ERROR;
+    }
+
+    //look up words of b, false on first word not present in a, hits are indexed by word id
+    int cmp = TRUE;
+    int hits_cnt = 0;
+    char *hits = (char *) calloc(table_size(&table) + 1, sizeof(char));
+    reader_init(&reader, b);
+    while (cmp && reader_next(&reader, &span)) {
+        int id = table_lookup(&table, reader.buffer + span.offset, (int) span.length);
+
+        if (id == TABLE_EMPTY) {
+            cmp = FALSE;
+        } else if (!hits[id]) {
+            hits[id] = TRUE;
+            hits_cnt++;
+        }
+    }
+    reader_free(&reader);
+
+    //every word of a must have been found in b
+    if (hits_cnt != table_size(&table)) {
+        cmp = FALSE;
+    }
+    if (ferror(b)) {
+        cmp = FILE_ERROR;
+    }
+
+    free(hits);
+    table_free(&table);
+    return cmp;
+}
+
+void reader_init(word_reader *reader, FILE *file) {
+    reader->file = file;
+    reader->buffer_size = 2 * FILE_CHUNK;
+    reader->buffer = (char *) malloc(reader->buffer_size);
+    reader->pos = 0;
+    reader->end = 0;
+    reader->prev_space = TRUE;
+    reader->eof = FALSE;
+}
+
+void reader_free(word_reader *reader) {
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
+
+int reader_next(word_reader *reader, word_span *span) {
+    while (!next_span(reader->buffer, &reader->pos, reader->end, reader->eof, span)) {
+        if (reader->eof) {
+            return FALSE;
+        }
+
+        //keep the unfinished word at the start of buffer, grow buffer if the word is longer than a chunk
+        memmove(reader->buffer, reader->buffer + reader->pos, reader->end - reader->pos);
+        reader->end -= reader->pos;
+        reader->pos = 0;
+        if (reader->buffer_size - reader->end < FILE_CHUNK) {
+            reader->buffer_size *= 2;
+            reader->buffer = (char *) realloc(reader->buffer, reader->buffer_size);
+        }
+
+        //read next chunk and normalize it in place
+        size_t read = fread(reader->buffer + reader->end, 1, FILE_CHUNK, reader->file);
+        if (read == 0) {
+            reader->eof = TRUE;
+        }
+        reader->end += format_chunk(reader->buffer + reader->end, reader->buffer + reader->end, read,
+                                    &reader->prev_space);
+    }
+
+    return TRUE;
+}
+
+void table_init(word_table *table, int words) {
+    table->table_size = set_slots_for(words);
+    table->table_used = 0;
+    table->entries = (table_entry *) malloc(table->table_size * sizeof(table_entry));
+    table->pool_size = 0;
+    table->pool_used = 0;
+    table->pool = NULL;
+
+    memset(table->entries, 0xff, table->table_size * sizeof(table_entry));    //id = TABLE_EMPTY
+}
+
+void table_free(word_table *table) {
+    free(table->entries);
+    free(table->pool);
+}
+
+void table_clear(word_table *table) {
+    memset(table->entries, 0xff, table->table_size * sizeof(table_entry));
+    table->table_used = 0;
+    table->pool_used = 0;
+}
+
+const char *table_text(const word_table *table, const table_entry *entry) {
+    if (entry->length <= TABLE_INLINE) {
+        return entry->word;
+    }
+
+    size_t offset;
+    memcpy(&offset, entry->word, sizeof(size_t));
+    return table->pool + offset;
+}
+
+int table_slot(const word_table *table, const char *word, int len, unsigned int hash) {
+    int mask = table->table_size - 1;
+    int slot = (int) (hash & (unsigned int) mask);
+
+    //linear probing, table is never full
+    while (table->entries[slot].id != TABLE_EMPTY) {
+        const table_entry *entry = &table->entries[slot];
+
+        if (entry->hash == hash && entry->length == (unsigned int) len &&
+            memcmp(table_text(table, entry), word, len) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+int table_insert(word_table *table, const char *word, int len) {
+    unsigned int hash = word_hash(word, len);
+    int slot = table_slot(table, word, len, hash);
+    table_entry *entry = &table->entries[slot];
+
+    if (entry->id != TABLE_EMPTY) {
+        return entry->id;
+    }
+
+    entry->hash = hash;
+    entry->length = (unsigned int) len;
+    entry->id = table->table_used++;
+    if (len <= TABLE_INLINE) {
+        memcpy(entry->word, word, len);
+    } else {
+        //long word goes to pool, slot keeps its offset
+        while (table->pool_size - table->pool_used < (size_t) len) {
+            table->pool_size = table->pool_size == 0 ? INIT_SIZE_VOCAB : 2 * table->pool_size;
+            table->pool = (char *) realloc(table->pool, table->pool_size);
+        }
+        memcpy(table->pool + table->pool_used, word, len);
+        memcpy(entry->word, &table->pool_used, sizeof(size_t));
+        table->pool_used += len;
+    }
+    int id = entry->id;
+
+    //keep load factor at most 1/2, rehash by stored hashes
+    if (2 * table->table_used > table->table_size) {
+        table_entry *entries = table->entries;
+        int size = table->table_size;
+
+        table->table_size *= 2;
+        table->entries = (table_entry *) malloc(table->table_size * sizeof(table_entry));
+        memset(table->entries, 0xff, table->table_size * sizeof(table_entry));
+
+        for (int i = 0; i < size; i++) {
+            if (entries[i].id != TABLE_EMPTY) {
+                int new_slot = (int) (entries[i].hash & (unsigned int) (table->table_size - 1));
+
+                while (table->entries[new_slot].id != TABLE_EMPTY) {
+                    new_slot = (new_slot + 1) & (table->table_size - 1);
+                }
+                table->entries[new_slot] = entries[i];
+            }
+        }
+        free(entries);
+    }
+
+    return id;
+}
+
+int table_lookup(const word_table *table, const char *word, int len) {
+    return table->entries[table_slot(table, word, len, word_hash(word, len))].id;
+}
+
+int table_contains(const word_table *table, const char *word, int len) {
+    return table_lookup(table, word, len) != TABLE_EMPTY ? TRUE : FALSE;
+}
+
+int table_size(const word_table *table) {
+    return table->table_used;
+}
+
+const table_entry *table_next(const word_table *table, int *pos) {
+    while (*pos < table->table_size) {
+        const table_entry *entry = &table->entries[(*pos)++];
+
+        if (entry->id != TABLE_EMPTY) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+void library_init(word_library *library) {
+    table_init(&library->words, INIT_SIZE_VOCAB);
+    library->postings_size = INIT_SIZE_ARR;
+    library->postings = (word_postings *) calloc(library->postings_size, sizeof(word_postings));
+    library->empty.docs = NULL;
+    library->empty.postings_size = 0;
+    library->empty.postings_used = 0;
+    library->docs_size = INIT_SIZE_ARR;
+    library->docs_used = 0;
+    library->doc_words = (int *) malloc(library->docs_size * sizeof(int));
+    library->doc_terms = (word_term **) malloc(library->docs_size * sizeof(word_term *));
+    library->counts = (int *) calloc(library->docs_size, sizeof(int));
+    library->free_docs = (int *) malloc(library->docs_size * sizeof(int));
+    library->free_used = 0;
+    library->terms = 0;
+    library->removed_terms = 0;
+}
+
+void library_free(word_library *library) {
+    for (int i = 0; i < table_size(&library->words); i++) {
+        free(library->postings[i].docs);
+    }
+    for (int i = 0; i < library->docs_used; i++) {
+        free(library->doc_terms[i]);
+    }
+
+    table_free(&library->words);
+    free(library->postings);
+    free(library->empty.docs);
+    free(library->doc_words);
+    free(library->doc_terms);
+    free(library->counts);
+    free(library->free_docs);
+}
+
+void postings_remove(word_library *library, word_postings *postings, int slot) {
+    //order does not matter, last document takes the place of the removed one
+    word_posting last = postings->docs[--postings->postings_used];
+
+    postings->docs[slot] = last;
+    library->doc_terms[last.doc][last.term].slot = slot;
+}
+
+int postings_add(word_postings *postings, int doc, int term) {
+    if (postings->postings_used == postings->postings_size) {
+        postings->postings_size = postings->postings_size == 0 ? 4 : 2 * postings->postings_size;
+        postings->docs = (word_posting *) realloc(postings->docs, postings->postings_size * sizeof(word_posting));
+    }
+
+    postings->docs[postings->postings_used].doc = doc;
+    postings->docs[postings->postings_used].term = term;
+    return postings->postings_used++;
+}
+
+int library_add(word_library *library, const char *str) {
+    word_arena arena;
+    char *text;
+    word_span *spans;
+    int cnt = tokenize_unique(str, &arena, &text, &spans);
+    int doc = library->free_used > 0 ? library->free_docs[--library->free_used] : library->docs_used++;
+
+    if (library->docs_used > library->docs_size) {
+        int size = library->docs_size;
+
+        library->docs_size *= 2;
+        library->doc_words = (int *) realloc(library->doc_words, library->docs_size * sizeof(int));
+        library->doc_terms = (word_term **) realloc(library->doc_terms, library->docs_size * sizeof(word_term *));
+        library->counts = (int *) realloc(library->counts, library->docs_size * sizeof(int));
+        library->free_docs = (int *) realloc(library->free_docs, library->docs_size * sizeof(int));
+        memset(library->counts + size, 0, (library->docs_size - size) * sizeof(int));
+    }
+
+    //doc_terms are dynamically allocated -> MUST BE FREED
+    library->doc_words[doc] = cnt;
+    library->doc_terms[doc] = (word_term *) malloc((cnt > 0 ? cnt : 1) * sizeof(word_term));
+    library->terms += cnt;
+
+    for (int i = 0; i < cnt; i++) {
+        int id = table_insert(&library->words, text + spans[i].offset, (int) spans[i].length);
+
+        //new word, posting lists follow word ids
+        if (id == library->postings_size) {
+            library->postings_size *= 2;
+            library->postings = (word_postings *) realloc(library->postings,
+                                                          library->postings_size * sizeof(word_postings));
+            memset(library->postings + id, 0, (library->postings_size - id) * sizeof(word_postings));
+        }
+
+        library->doc_terms[doc][i].id = id;
+        library->doc_terms[doc][i].slot = postings_add(&library->postings[id], doc, i);
+    }
+    if (cnt == 0) {
+        library->doc_terms[doc][0].id = TABLE_EMPTY;
+        library->doc_terms[doc][0].slot = postings_add(&library->empty, doc, 0);
+    }
+
+    arena_free(&arena);
+    return doc;
+}
+
+int library_remove(word_library *library, int doc) {
+    if (doc < 0 || doc >= library->docs_used || library->doc_words[doc] == LIBRARY_REMOVED) {
+        return FALSE;
+    }
+
+    int cnt = library->doc_words[doc];
+    word_term *terms = library->doc_terms[doc];
+    for (int i = 0; i < cnt; i++) {
+        postings_remove(library, &library->postings[terms[i].id], terms[i].slot);
+    }
+    if (cnt == 0) {
+        postings_remove(library, &library->empty, terms[0].slot);
+    }
+
+    free(terms);
+    library->doc_terms[doc] = NULL;
+    library->doc_words[doc] = LIBRARY_REMOVED;
+    library->free_docs[library->free_used++] = doc;
+    library->terms -= cnt;
+    library->removed_terms += cnt;
+
+    //words only removed documents had are dropped once there are more of them than stored words
+    if (library->removed_terms > library->terms) {
+        library_compact(library);
+    }
+    return TRUE;
+}
+
+void library_compact(word_library *library) {
+    word_table words;
+    word_postings *postings = (word_postings *) calloc(library->postings_size, sizeof(word_postings));
+    const table_entry *entry;
+    int pos = 0;
+
+    //words and postings are moved to new ids, words in no document are left out
+    table_init(&words, INIT_SIZE_VOCAB);
+    while ((entry = table_next(&library->words, &pos)) != NULL) {
+        word_postings *old = &library->postings[entry->id];
+
+        if (old->postings_used == 0) {
+            free(old->docs);
+            continue;
+        }
+
+        int id = table_insert(&words, table_text(&library->words, entry), (int) entry->length);
+        postings[id] = *old;
+        for (int j = 0; j < old->postings_used; j++) {
+            library->doc_terms[old->docs[j].doc][old->docs[j].term].id = id;
+        }
+    }
+
+    table_free(&library->words);
+    free(library->postings);
+    library->words = words;
+    library->postings = postings;
+    library->removed_terms = 0;
+}
+
+int *library_query(word_library *library, const char *str, int mode, int *docs_cnt) {
+    word_arena arena;
+    char *text;
+    word_span *spans;
+    int cnt = tokenize_unique(str, &arena, &text, &spans);
+    int size = INIT_SIZE_ARR;
+    int *docs = (int *) malloc(size * sizeof(int));
+    *docs_cnt = 0;
+
+    //ids of known words of str, unknown words are in no document
+    //docs, ids are dynamically allocated -> MUST BE FREED (docs by caller)
+    int known = 0;
+    int *ids = (int *) malloc((cnt > 0 ? cnt : 1) * sizeof(int));
+    for (int i = 0; i < cnt; i++) {
+        int id = table_lookup(&library->words, text + spans[i].offset, (int) spans[i].length);
+
+        if (id != TABLE_EMPTY) {
+            ids[known++] = id;
+        }
+    }
+    arena_free(&arena);
+
+    if (mode == LIBRARY_SUPERSET && cnt == 0) {
+        //every document has at least no words
+        for (int doc = 0; doc < library->docs_used; doc++) {
+            if (library->doc_words[doc] != LIBRARY_REMOVED) {
+                if (*docs_cnt == size) {
+                    size *= 2;
+                    docs = (int *) realloc(docs, size * sizeof(int));
+                }
+                docs[(*docs_cnt)++] = doc;
+            }
+        }
+        free(ids);
+        return docs;
+    }
+
+    //count words of str in every document that has some
+    for (int i = 0; i < known; i++) {
+        word_postings *postings = &library->postings[ids[i]];
+
+        for (int j = 0; j < postings->postings_used; j++) {
+            library->counts[postings->docs[j].doc]++;
+        }
+    }
+
+    //collect matching documents, counts are reset on the way
+    for (int i = 0; i <= known; i++) {
+        word_postings *postings = i < known ? &library->postings[ids[i]] : &library->empty;
+
+        for (int j = 0; j < postings->postings_used; j++) {
+            int doc = postings->docs[j].doc;
+            int count = library->counts[doc];
+            int words = library->doc_words[doc];
+            int match;
+
+            if (i < known && count == 0) {
+                //already collected
+                continue;
+            }
+            library->counts[doc] = 0;
+
+            if (mode == LIBRARY_EXACT) {
+                match = count == cnt && words == cnt;
+            } else if (mode == LIBRARY_SUPERSET) {
+                match = count == cnt;
+            } else {
+                match = count == words;
+            }
+
+            if (match) {
+                if (*docs_cnt == size) {
+                    size *= 2;
+                    docs = (int *) realloc(docs, size * sizeof(int));
+                }
+                docs[(*docs_cnt)++] = doc;
+            }
+        }
+    }
+
+    qsort(docs, *docs_cnt, sizeof(int), compare_ints);
+    free(ids);
+    return docs;
+}
+
+void tracker_init(word_tracker *tracker, const char *a, const char *b) {
+    table_init(&tracker->words, INIT_SIZE_VOCAB);
+    tracker->counts_size = INIT_SIZE_ARR;
+    tracker->counts[TRACKER_A] = (int *) calloc(tracker->counts_size, sizeof(int));
+    tracker->counts[TRACKER_B] = (int *) calloc(tracker->counts_size, sizeof(int));
+    tracker->mismatch = 0;
+
+    tracker_apply(tracker, TRACKER_A, a, strlen(a), 1);
+    tracker_apply(tracker, TRACKER_B, b, strlen(b), 1);
+}
+
+void tracker_free(word_tracker *tracker) {
+    table_free(&tracker->words);
+    free(tracker->counts[TRACKER_A]);
+    free(tracker->counts[TRACKER_B]);
+}
+
+int tracker_same(const word_tracker *tracker) {
+    return tracker->mismatch == 0 ? TRUE : FALSE;
+}
+
+int tracker_insert(word_tracker *tracker, int doc, const char *str) {
+    return tracker_apply(tracker, doc, str, strlen(str), 1);
+}
+
+int tracker_delete(word_tracker *tracker, int doc, const char *str) {
+    return tracker_apply(tracker, doc, str, strlen(str), -1);
+}
+
+int tracker_replace(word_tracker *tracker, int doc, const char *text, size_t text_len, size_t start, size_t end,
+                    const char *replacement) {
+    size_t replacement_len = strlen(replacement);
+
+    //length is given, edits of long documents stay local
+    if (start > end || end > text_len) {
+        return FALSE;
+    }
+
+    //words of text[left, right) do not depend on chars outside, left boundary is before the edit and right one is
+    //after it together with the two chars that decide it (@see word_boundary())
+    size_t left = start;
+    while (left > 0 && !(left > 1 && text[left - 1] == DELIM[0] && !isspace((unsigned char) text[left - 2]))) {
+        left--;
+    }
+    size_t right = end;
+    while (right < text_len &&
+           (right < end + 2 || !(text[right - 1] == DELIM[0] && !isspace((unsigned char) text[right - 2])))) {
+        right++;
+    }
+
+    //region after the edit, region is dynamically allocated -> MUST BE FREED
+    size_t region_len = (start - left) + replacement_len + (right - end);
+    char *region = (char *) malloc(region_len + 1);
+    memcpy(region, text + left, start - left);
+    memcpy(region + (start - left), replacement, replacement_len);
+    memcpy(region + (start - left) + replacement_len, text + end, right - end);
+
+    int cmp = tracker_apply(tracker, doc, text + left, right - left, -1);
+    if (cmp) {
+        tracker_apply(tracker, doc, region, region_len, 1);
+    }
+
+    free(region);
+    return cmp;
+}
+
+int tracker_apply(word_tracker *tracker, int doc, const char *str, size_t len, int delta) {
+    word_arena arena;
+    int max_words = (int) (len / 2 + 1);
+    arena_init(&arena, (len + 1) + max_words * sizeof(word_span) + 2 * ARENA_ALIGN);
+
+    char *text = (char *) arena_alloc(&arena, len + 1);
+    word_span *spans = (word_span *) arena_alloc(&arena, max_words * sizeof(word_span));
+    int cnt = tokenize(str, len, text, spans);
+    int *counts = tracker->counts[doc];
+    int *other = tracker->counts[1 - doc];
+    int done;
+
+    for (done = 0; done < cnt; done++) {
+        const char *word = text + spans[done].offset;
+        int len_word = (int) spans[done].length;
+        int id = delta > 0 ? table_insert(&tracker->words, word, len_word)
+                           : table_lookup(&tracker->words, word, len_word);
+
+        //counts follow word ids
+        if (id == tracker->counts_size) {
+            tracker->counts_size *= 2;
+            for (int i = 0; i < 2; i++) {
+                tracker->counts[i] = (int *) realloc(tracker->counts[i], tracker->counts_size * sizeof(int));
+                memset(tracker->counts[i] + id, 0, (tracker->counts_size - id) * sizeof(int));
+            }
+            counts = tracker->counts[doc];
+            other = tracker->counts[1 - doc];
+        }
+
+        if (id == TABLE_EMPTY || counts[id] + delta < 0) {
+            break;
+        }
+
+        //word appears in or disappears from doc
+        if ((counts[id] == 0) != (counts[id] + delta == 0)) {
+            tracker->mismatch += other[id] == 0 ? (counts[id] == 0 ? 1 : -1) : (counts[id] == 0 ? -1 : 1);
+        }
+        counts[id] += delta;
+    }
+
+    //undo words before the one that failed
+    int cmp = done == cnt ? TRUE : FALSE;
+    for (int i = 0; i < done && !cmp; i++) {
+        int id = table_lookup(&tracker->words, text + spans[i].offset, (int) spans[i].length);
+
+        if ((counts[id] == 0) != (counts[id] - delta == 0)) {
+            tracker->mismatch += other[id] == 0 ? (counts[id] == 0 ? 1 : -1) : (counts[id] == 0 ? -1 : 1);
+        }
+        counts[id] -= delta;
+    }
+
+    arena_free(&arena);
+    return cmp;
+}
+
+int compare_ints(const void *a, const void *b) {
+    int int_a = *(const int *) a;
+    int int_b = *(const int *) b;
+
+    return (int_a > int_b) - (int_a < int_b);
+}
+
+size_t word_boundary(const char *str, size_t len, size_t from) {
+    //the first whitespace after non-whitespace is kept, if it is DELIM it separates words
+    for (size_t i = from > 0 ? from - 1 : 0; i < len; i++) {
+        if (str[i] == DELIM[0] && (i == 0 || !isspace((unsigned char) str[i - 1]))) {
+            return i + 1;
+        }
+    }
+
+    return len;
+}
+
+void *tokenize_worker(void *arg) {
+    tokenize_job *job = (tokenize_job *) arg;
+
+    for (int doc = 0; doc < 2; doc++) {
+        size_t start = job->start[doc];
+
+        //range starts after a separating space or at the start of string, either way previous char is whitespace
+        int prev_space = TRUE;
+        size_t end = start + format_chunk(job->text[doc] + start, job->raw[doc] + start, job->end[doc] - start,
+                                          &prev_space);
+        size_t pos = start;
+        word_span span;
+
+        while (next_span(job->text[doc], &pos, end, TRUE, &span)) {
+            unsigned int hash = word_hash(job->text[doc] + span.offset, (int) span.length);
+            word_bucket *bucket = &job->buckets[doc][(unsigned long long) hash * job->partitions >> 32];
+
+            if (bucket->bucket_used == bucket->bucket_size) {
+                bucket->bucket_size = bucket->bucket_size == 0 ? INIT_SIZE_ARR : 2 * bucket->bucket_size;
+                bucket->entries = (word_entry *) realloc(bucket->entries, bucket->bucket_size * sizeof(word_entry));
+            }
+
+            bucket->entries[bucket->bucket_used].hash = hash;
+            bucket->entries[bucket->bucket_used].span = span;
+            bucket->bucket_used++;
+        }
+    }
+
+    return NULL;
+}
+
+void *compare_worker(void *arg) {
+    compare_job *job = (compare_job *) arg;
+    int k = job->partition;
+    int a_cnt = 0;
+
+    for (int t = 0; t < job->jobs_cnt; t++) {
+        a_cnt += job->jobs[t].buckets[0][k].bucket_used;
+    }
+
+    //words of a in this partition, spans point into normalized a
+    word_arena arena;
+    arena_init(&arena, (a_cnt > 0 ? a_cnt : 1) * sizeof(word_span) +
+                       set_slots_for(a_cnt) * (sizeof(int) + sizeof(unsigned int) + sizeof(char)) +
+                       4 * ARENA_ALIGN);
+    word_span *spans = (word_span *) arena_alloc(&arena, (a_cnt > 0 ? a_cnt : 1) * sizeof(word_span));
+    word_set set;
+    set_init(&set, &arena, set_slots_for(a_cnt), job->jobs[0].text[0], spans);
+
+    //insert words of a, hashes were computed by tokenize_worker()
+    for (int t = 0; t < job->jobs_cnt; t++) {
+        word_bucket *bucket = &job->jobs[t].buckets[0][k];
+
+        for (int i = 0; i < bucket->bucket_used; i++) {
+            word_entry *entry = &bucket->entries[i];
+            int slot = set_slot(&set, set.text + entry->span.offset, (int) entry->span.length, entry->hash);
+
+            if (set.slots[slot] == SET_EMPTY) {
+                spans[set.set_used] = entry->span;
+                set.slots[slot] = set.set_used++;
+                set.hashes[slot] = entry->hash;
+            }
+        }
+    }
+
+    //look up words of b, stop on first miss here or in other partition
+    const char *b_text = job->jobs[0].text[1];
+    int hits = 0;
+    int cmp = TRUE;
+
+    for (int t = 0; cmp && t < job->jobs_cnt; t++) {
+        word_bucket *bucket = &job->jobs[t].buckets[1][k];
+
+        for (int i = 0; i < bucket->bucket_used; i++) {
+            word_entry *entry = &bucket->entries[i];
+            int slot = set_slot(&set, b_text + entry->span.offset, (int) entry->span.length, entry->hash);
+
+            if (set.slots[slot] == SET_EMPTY) {
+                cmp = FALSE;
+                break;
+            } else if (!set.hits[slot]) {
+                set.hits[slot] = TRUE;
+                hits++;
+            }
+        }
+
+        if (__atomic_load_n(job->mismatch, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (!cmp || hits != set.set_used) {
+        __atomic_store_n(job->mismatch, TRUE, __ATOMIC_RELAXED);
+    }
+
+    arena_free(&arena);
+    return NULL;
+}
+
+int sameWordsParallel(const char *a, const char *b, int threads_cnt) {
+#ifndef WORDS_THREADS
+    (void) threads_cnt;
+    return sameWords(a, b);
+#else
+    if (threads_cnt <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads_cnt = cpus < 1 ? 1 : (int) cpus;
+    }
+    if (threads_cnt > THREADS_MAX) {
+        threads_cnt = THREADS_MAX;
+    }
+
+    //kernel is selected before threads start
+    format_init();
+
+    const char *raw[2] = {a, b};
+    size_t len[2] = {strlen(a), strlen(b)};
+    char *text[2];
+    tokenize_job jobs[THREADS_MAX];
+    compare_job compares[THREADS_MAX];
+    pthread_t threads[THREADS_MAX];
+    int started[THREADS_MAX];
+    int mismatch = FALSE;
+
+    //text, buckets are dynamically allocated -> MUST BE FREED
+    for (int doc = 0; doc < 2; doc++) {
+        text[doc] = (char *) malloc(len[doc] + 1);
+    }
+
+    //split both strings into ranges at word boundaries
+    for (int t = 0; t < threads_cnt; t++) {
+        for (int doc = 0; doc < 2; doc++) {
+            jobs[t].raw[doc] = raw[doc];
+            jobs[t].text[doc] = text[doc];
+            jobs[t].start[doc] = t == 0 ? 0 : jobs[t - 1].end[doc];
+            jobs[t].end[doc] = t == threads_cnt - 1 ? len[doc] :
+                               word_boundary(raw[doc], len[doc], len[doc] / threads_cnt * (t + 1));
+            if (jobs[t].end[doc] < jobs[t].start[doc]) {
+                jobs[t].end[doc] = jobs[t].start[doc];
+            }
+            jobs[t].buckets[doc] = (word_bucket *) calloc(threads_cnt, sizeof(word_bucket));
+        }
+        jobs[t].partitions = threads_cnt;
+    }
+
+    //job 0 runs on the calling thread, so does every job whose thread can't be created
+    for (int t = 1; t < threads_cnt; t++) {
+        started[t] = pthread_create(&threads[t], NULL, tokenize_worker, &jobs[t]) == 0;
+    }
+    tokenize_worker(&jobs[0]);
+    for (int t = 1; t < threads_cnt; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            tokenize_worker(&jobs[t]);
+        }
+    }
+
+    for (int k = 0; k < threads_cnt; k++) {
+        compares[k].jobs = jobs;
+        compares[k].jobs_cnt = threads_cnt;
+        compares[k].partition = k;
+        compares[k].mismatch = &mismatch;
+    }
+    for (int k = 1; k < threads_cnt; k++) {
+        started[k] = pthread_create(&threads[k], NULL, compare_worker, &compares[k]) == 0;
+    }
+    compare_worker(&compares[0]);
+    for (int k = 1; k < threads_cnt; k++) {
+        if (started[k]) {
+            pthread_join(threads[k], NULL);
+        } else {
+            compare_worker(&compares[k]);
+        }
+    }
+
+    for (int t = 0; t < threads_cnt; t++) {
+        for (int doc = 0; doc < 2; doc++) {
+            for (int k = 0; k < threads_cnt; k++) {
+                free(jobs[t].buckets[doc][k].entries);
+            }
+            free(jobs[t].buckets[doc]);
+        }
+    }
+    free(text[0]);
+    free(text[1]);
+
+    return mismatch ? FALSE : TRUE;
+#endif
+}
+
+int sameWordsRadix(const char *a, const char *b) {
+    word_arena arena_a, arena_b;
+    char *text_a, *text_b;
+    word_span *spans_a, *spans_b;
+    int cnt_a = tokenize_sorted(a, &arena_a, &text_a, &spans_a);
+    int cnt_b = tokenize_sorted(b, &arena_b, &text_b, &spans_b);
+    int cmp = cnt_a == cnt_b ? TRUE : FALSE;
+
+    //sorted unique words must be the same one by one
+    for (int i = 0; cmp && i < cnt_a; i++) {
+        if (spans_a[i].length != spans_b[i].length ||
+            memcmp(text_a + spans_a[i].offset, text_b + spans_b[i].offset, spans_a[i].length) != 0) {
+            cmp = FALSE;
+        }
+    }
+
+    arena_free(&arena_a);
+    arena_free(&arena_b);
+    return cmp;
+}
+
+int tokenize_sorted(const char *str, word_arena *arena, char **text, word_span **spans) {
+    size_t len = strlen(str);
+    int max_words = (int) (len / 2 + 1);
+
+    arena_init(arena, (len + 1) + max_words * sizeof(word_span) + 2 * ARENA_ALIGN);
+
+    *text = (char *) arena_alloc(arena, len + 1);
+    *spans = (word_span *) arena_alloc(arena, max_words * sizeof(word_span));
+    int cnt = tokenize(str, len, *text, *spans);
+
+    return span_sort(*text, *spans, cnt, 0, *spans);
+}
+
+int span_char(const char *text, word_span span, unsigned int depth) {
+    return depth < span.length ? (unsigned char) text[span.offset + depth] : 0;
+}
+
+int span_compare(const char *text, word_span a, word_span b, unsigned int depth) {
+    unsigned int len = a.length < b.length ? a.length : b.length;
+    int cmp = len > depth ? memcmp(text + a.offset + depth, text + b.offset + depth, len - depth) : 0;
+
+    if (cmp != 0) {
+        return cmp;
+    }
+    return a.length < b.length ? -1 : a.length > b.length;
+}
+
+int span_sort(const char *text, word_span *spans, int n, unsigned int depth, word_span *out) {
+    word_span *start = out;
+    word_span tmp;
+
+    while (n > 0) {
+        if (n < SORT_INSERTION) {
+            //insertion sort, then copy words that differ from the previous one
+            for (int i = 1; i < n; i++) {
+                tmp = spans[i];
+                int j = i;
+                while (j > 0 && span_compare(text, spans[j - 1], tmp, depth) > 0) {
+                    spans[j] = spans[j - 1];
+                    j--;
+                }
+                spans[j] = tmp;
+            }
+            for (int i = 0; i < n; i++) {
+                if (i == 0 || span_compare(text, spans[i - 1], spans[i], depth) != 0) {
+                    *out++ = spans[i];
+                }
+            }
+            break;
+        }
+
+        //pivot = median of chars of first, middle, last word
+        int c1 = span_char(text, spans[0], depth);
+        int c2 = span_char(text, spans[n / 2], depth);
+        int c3 = span_char(text, spans[n - 1], depth);
+        int pivot = c1 < c2 ? (c2 < c3 ? c2 : (c1 < c3 ? c3 : c1)) : (c1 < c3 ? c1 : (c2 < c3 ? c3 : c2));
+
+        //[0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot
+        int lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            int c = span_char(text, spans[i], depth);
+
+            if (c < pivot) {
+                tmp = spans[lt];
+                spans[lt++] = spans[i];
+                spans[i++] = tmp;
+            } else if (c > pivot) {
+                tmp = spans[--gt];
+                spans[gt] = spans[i];
+                spans[i] = tmp;
+            } else {
+                i++;
+            }
+        }
+
+        if (lt == 0 && gt == n) {
+            //every word has the same char here
+            if (pivot == 0) {
+                *out++ = spans[0];
+                break;
+            }
+            depth++;
+            continue;
+        }
+
+        out += span_sort(text, spans, lt, depth, out);
+        if (pivot == 0) {
+            //words ending here are all the same word
+            *out++ = spans[lt];
+        } else {
+            out += span_sort(text, spans + lt, gt - lt, depth + 1, out);
+        }
+
+        spans += gt;
+        n -= gt;
+    }
+
+    return (int) (out - start);
+}
+
+char *get_copy(const char *str) {
+    size_t size = strlen(str);
+    char *copy = (char *) calloc(size + 1, sizeof(char));
+    for (size_t i = 0; i < size; i++) {
+        copy[i] = str[i];
+    }
+
+    return copy;
+}
+
+void str_format(char *str) {
+    int prev_space = TRUE;
+
+    //remove extra whitespaces and lowercase all characters
+    str[format_chunk(str, str, strlen(str), &prev_space)] = '\0';
+}
+
+list_t init_list() {
+    word_list *wlist = (word_list *) malloc(sizeof(word_list));
+    wlist->list_size = INIT_SIZE_ARR;
+    wlist->list_used = 0;
+    wlist->list = (char **) calloc(INIT_SIZE_ARR, sizeof(char *));
+
+    for (int i = 0; i < INIT_SIZE_ARR; i++) {
+        wlist->list[i] = (char *) calloc(INIT_SIZE_STR, sizeof(char));
+    }
+
+    return wlist;
+}
+
+void free_list(list_t in) {
+    word_list *wlist = (word_list *) in;
+    for (int i = 0; i < wlist->list_size; i++) {
+        free(wlist->list[i]);
+    }
+
+    free(wlist->list);
+    free(wlist);
+}
+
+void list_resize(list_t in, int new_size) {
+    word_list *wlist = (word_list *) in;
+
+    //free strings that do not fit into the new size
+    for (int i = new_size; i < wlist->list_size; i++) {
+        free(wlist->list[i]);
+    }
+
+    int old_size = wlist->list_size;
+    wlist->list_size = new_size;
+    wlist->list = (char **) realloc(wlist->list, wlist->list_size * sizeof(char *));
+    for (int i = old_size; i < wlist->list_size; i++) {
+        wlist->list[i] = (char *) calloc(INIT_SIZE_STR, sizeof(char));
+    }
+}
+
+void parse_words(list_t in, char *str) {
+    word_list *wlist = (word_list *) in;
+    char *parsed = strtok(str, DELIM); //get first word from str
+
+    int index = 0;
+
+    while (parsed != NULL) { //str is empty if parsed == NULL
+        //keep at least one empty string after used words, list_remove_duplicates() reads it
+        if (wlist->list_size == wlist->list_used + 1) {
+            list_resize(in, 2 * wlist->list_size);
+        }
+
+        wlist->list[index] = (char *) realloc(wlist->list[index],
+                                              strlen(parsed) + 1); //change size of list[index] to size of parsed
+        strcpy(wlist->list[index], parsed);
+
+        index++;
+        wlist->list_used++;
+        parsed = strtok(NULL, DELIM); //get next word from original string
+    }
+}
+
+int list_compare(list_t a, list_t b) {
+    word_list *wlist_a = (word_list *) a;
+    word_list *wlist_b = (word_list *) b;
+
+
+    //sort both lists alphabetically
+    qsort(wlist_a->list, wlist_a->list_used, sizeof wlist_a->list[0], compare);
+    qsort(wlist_b->list, wlist_b->list_used, sizeof wlist_b->list[0], compare);
+
+    //remove duplicates from lists
+    list_remove_duplicates(a);
+    list_remove_duplicates(b);
+
+    //false is used sizes differ
+    if (wlist_a->list_used != wlist_b->list_used) {
+        return FALSE;
+    }
+
+    //iterate over list_a and compare contents to list_b, false if mismatch is found
+    for (int i = 0; i < wlist_a->list_used; i++) {
+        if (strcmp(wlist_a->list[i], wlist_b->list[i])) {
+            return FALSE;
+        }
+    }
+
+    //lists match
+    return TRUE;
+}
+
+int compare(const void *a, const void *b) {
+    char **ch_a = (char **) a;
+    char **ch_b = (char **) b;
+
+    return strcmp(*ch_a, *ch_b);
+}
+
+void list_remove_duplicates(list_t in) {
+    word_list *wlist = (word_list *) in;
+    int i, j;
+    int n = wlist->list_used;
+
+
+    //iterate over sorted list and remove duplicates
+    for (i = j = 0; i < n; i++) {
+        if (strcmp(wlist->list[i], wlist->list[i + 1])) {
+            //word is already in place if no duplicate was removed yet
+            if (j != i) {
+                wlist->list[j] = (char *) realloc(wlist->list[j], strlen(wlist->list[i]) + 1);
+                strcpy(wlist->list[j], wlist->list[i]);
+            }
             j++;
         }
     }
 
-    free(wlist->list[j]);
-    wlist->list[j] = (char *) calloc(strlen(wlist->list[n]) + 1, sizeof(char));
-    strcpy(wlist->list[j++], wlist->list[n]);
+    //copy empty string from list[n] after the last unique word
+    if (j != n) {
+        free(wlist->list[j]);
+        wlist->list[j] = (char *) calloc(strlen(wlist->list[n]) + 1, sizeof(char));
+        strcpy(wlist->list[j], wlist->list[n]);
+    }
+    j++;
+
+    //resize to free unused memory
+    list_resize(in, j);
+    wlist->list_used = j;
+}
+
+size_t format_chunk(char *dst, const char *src, size_t n, int *prev_space) {
+    format_init();
+    return format_chunk_impl(dst, src, n, prev_space);
+}
+
+size_t format_chunk_scalar(char *dst, const char *src, size_t n, int *prev_space) {
+    size_t j = 0;
+    int prev = *prev_space;
+
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char) src[i];
+        int space = isspace(c) != 0;
+
+        if ((!space || !prev) && (isalpha(c) || space)) {
+            dst[j++] = (char) tolower(c);
+        }
+        prev = space;
+    }
+
+    *prev_space = prev;
+    return j;
+}
+
+#ifdef FORMAT_SIMD
+
+size_t format_chunk_sse2(char *dst, const char *src, size_t n, int *prev_space) {
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i before_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_z = _mm_set1_epi8('z' + 1);
+    const __m128i before_tab = _mm_set1_epi8('\t' - 1);
+    const __m128i after_cr = _mm_set1_epi8('\r' + 1);
+    const __m128i space = _mm_set1_epi8(' ');
+    unsigned int carry = *prev_space ? 1 : 0;
+    unsigned char block[16];
+    size_t i = 0;
+    size_t j = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *) (src + i));
+
+        //letters: c | 0x20 in 'a'-'z', whitespace: ' ' or '\t'-'\r', chars >= 128 compare as negative
+        __m128i lower = _mm_or_si128(c, case_bit);
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, before_a), _mm_cmplt_epi8(lower, after_z));
+        __m128i white = _mm_or_si128(_mm_cmpeq_epi8(c, space),
+                                     _mm_and_si128(_mm_cmpgt_epi8(c, before_tab), _mm_cmplt_epi8(c, after_cr)));
+        __m128i out = _mm_or_si128(_mm_and_si128(alpha, lower), _mm_andnot_si128(alpha, c));
+
+        //whitespace is kept if the previous char is not whitespace, kept whitespace marks word boundaries
+        unsigned int alpha_bits = (unsigned int) _mm_movemask_epi8(alpha);
+        unsigned int white_bits = (unsigned int) _mm_movemask_epi8(white);
+        unsigned int keep = (alpha_bits | (white_bits & ~((white_bits << 1) | carry))) & 0xFFFF;
+        carry = white_bits >> 15;
+
+        //j <= i, so in place output never overwrites chars that were not loaded yet
+        if (keep == 0xFFFF) {
+            _mm_storeu_si128((__m128i *) (dst + j), out);
+            j += 16;
+            continue;
+        }
+
+        _mm_storeu_si128((__m128i *) block, out);
+        while (keep) {
+            dst[j++] = (char) block[__builtin_ctz(keep)];
+            keep &= keep - 1;
+        }
+    }
+
+    *prev_space = (int) carry;
+    return j + format_chunk_scalar(dst + j, src + i, n - i, prev_space);
+}
+
+__attribute__((target("avx2")))
+size_t format_chunk_avx2(char *dst, const char *src, size_t n, int *prev_space) {
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i before_a = _mm256_set1_epi8('a' - 1);
+    const __m256i after_z = _mm256_set1_epi8('z' + 1);
+    const __m256i before_tab = _mm256_set1_epi8('\t' - 1);
+    const __m256i after_cr = _mm256_set1_epi8('\r' + 1);
+    const __m256i space = _mm256_set1_epi8(' ');
+    unsigned int carry = *prev_space ? 1 : 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *) (src + i));
+
+        //@see format_chunk_sse2()
+        __m256i lower = _mm256_or_si256(c, case_bit);
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, before_a), _mm256_cmpgt_epi8(after_z, lower));
+        __m256i white = _mm256_or_si256(_mm256_cmpeq_epi8(c, space),
+                                        _mm256_and_si256(_mm256_cmpgt_epi8(c, before_tab),
+                                                         _mm256_cmpgt_epi8(after_cr, c)));
+        __m256i out = _mm256_blendv_epi8(c, lower, alpha);
+
+        unsigned int alpha_bits = (unsigned int) _mm256_movemask_epi8(alpha);
+        unsigned int white_bits = (unsigned int) _mm256_movemask_epi8(white);
+        unsigned int keep = alpha_bits | (white_bits & ~((white_bits << 1) | carry));
+        carry = white_bits >> 31;
+
+        if (keep == 0xFFFFFFFFu) {
+            _mm256_storeu_si256((__m256i *) (dst + j), out);
+            j += 32;
+            continue;
+        }
+
+        //pack each 8 chars by shuffle, 8 bytes are stored but only kept ones are counted
+        __m128i low = _mm256_castsi256_si128(out);
+        __m128i high = _mm256_extracti128_si256(out, 1);
+        __m128i groups[4] = {low, _mm_srli_si128(low, 8), high, _mm_srli_si128(high, 8)};
+
+        for (int g = 0; g < 4; ++g) {
+            unsigned int bits = (keep >> (8 * g)) & 0xFF;
+            __m128i packed = _mm_shuffle_epi8(groups[g], _mm_loadl_epi64((const __m128i *) format_shuffle[bits]));
+
+            _mm_storel_epi64((__m128i *) (dst + j), packed);
+            j += (size_t) __builtin_popcount(bits);
+        }
+    }
+
+    *prev_space = (int) carry;
+    return j + format_chunk_scalar(dst + j, src + i, n - i, prev_space);
+}
+
+#endif /* FORMAT_SIMD */
+
+void format_init() {
+#ifdef WORDS_THREADS
+    pthread_once(&format_once, format_select);
+#else
+    if (format_chunk_impl == NULL) {
+        format_select();
+    }
+#endif
+}
+
+void format_select() {
+    format_fn impl = format_chunk_scalar;
+
+#ifdef FORMAT_SIMD
+    impl = format_chunk_sse2;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        for (int mask = 0; mask < 256; mask++) {
+            int k = 0;
+
+            for (int bit = 0; bit < 8; bit++) {
+                if (mask & (1 << bit)) {
+                    format_shuffle[mask][k++] = (unsigned char) bit;
+                }
+            }
+            while (k < 8) {
+                format_shuffle[mask][k++] = 0x80;
+            }
+        }
+
+        impl = format_chunk_avx2;
+    }
+#endif
+
+    format_chunk_impl = impl;
+}
 
-    //resize to free unused memory
-    list_resize(in, j);
-    wlist->list_used = j;
+int next_span(const char *text, size_t *pos, size_t end, int last, word_span *span) {
+    size_t i = *pos;
+
+    //skip separators
+    while (i < end && text[i] == DELIM[0]) {
+        i++;
+    }
+    *pos = i;
+
+    if (i == end) {
+        return FALSE;
+    }
+
+    const char *delim = (const char *) memchr(text + i, DELIM[0], end - i);
+    if (delim == NULL && !last) {
+        return FALSE;
+    }
+
+    size_t word_end = delim == NULL ? end : (size_t) (delim - text);
+    span->offset = (unsigned int) i;
+    span->length = (unsigned int) (word_end - i);
+    *pos = word_end;
+    return TRUE;
+}
+
+unsigned int word_hash(const char *word, int len) {
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < len; i++) {
+        hash ^= (unsigned char) word[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//64-bit rotation for word_hash128()
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+unsigned long long fmix64(unsigned long long k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+void word_hash128(const char *word, int len, unsigned long long *low, unsigned long long *high) {
+    const unsigned long long c1 = 0x87c37b91114253d5ULL;
+    const unsigned long long c2 = 0x4cf5ad432745937fULL;
+    const unsigned char *data = (const unsigned char *) word;
+    unsigned long long h1 = 0;
+    unsigned long long h2 = 0;
+    unsigned long long k1;
+    unsigned long long k2;
+    int blocks = len / 16;
+
+    //16 byte blocks
+    for (int i = 0; i < blocks; i++) {
+        memcpy(&k1, data + 16 * i, 8);
+        memcpy(&k2, data + 16 * i + 8, 8);
+
+        k1 *= c1;
+        k1 = ROTL64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = ROTL64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = ROTL64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = ROTL64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    //remaining bytes (little endian)
+    const unsigned char *tail = data + 16 * blocks;
+    int rest = len & 15;
+    k1 = 0;
+    k2 = 0;
+    for (int i = rest - 1; i >= 8; i--) {
+        k2 = (k2 << 8) | tail[i];
+    }
+    for (int i = (rest < 8 ? rest : 8) - 1; i >= 0; i--) {
+        k1 = (k1 << 8) | tail[i];
+    }
+    if (rest > 8) {
+        k2 *= c2;
+        k2 = ROTL64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    if (rest > 0) {
+        k1 *= c1;
+        k1 = ROTL64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= (unsigned long long) len;
+    h2 ^= (unsigned long long) len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    *low = h1;
+    *high = h2;
+}
+
+int tokenize(const char *str, size_t len, char *text, word_span *spans) {
+    int prev_space = TRUE;
+    size_t end = format_chunk(text, str, len, &prev_space);
+    size_t pos = 0;
+    int cnt = 0;
+
+    while (next_span(text, &pos, end, TRUE, &spans[cnt])) {
+        cnt++;
+    }
+
+    return cnt;
+}
+
+void arena_init(word_arena *arena, size_t size) {
+    arena->data = (char *) malloc(size);
+    arena->arena_size = size;
+    arena->arena_used = 0;
+}
+
+void *arena_alloc(word_arena *arena, size_t size) {
+    //round start up to ARENA_ALIGN
+    size_t start = (arena->arena_used + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+    arena->arena_used = start + size;
+    return arena->data + start;
+}
+
+void arena_free(word_arena *arena) {
+    free(arena->data);
+    arena->data = NULL;
+    arena->arena_size = 0;
+    arena->arena_used = 0;
+}
+
+int set_slots_for(int words) {
+    int size = 2;
+
+    while (size < 2 * words) {
+        size *= 2;
+    }
+
+    return size;
+}
+
+void set_init(word_set *set, word_arena *arena, int size, const char *text, word_span *spans) {
+    set->set_size = size;
+    set->set_used = 0;
+    set->text = text;
+    set->spans = spans;
+    set->slots = (int *) arena_alloc(arena, size * sizeof(int));
+    set->hashes = (unsigned int *) arena_alloc(arena, size * sizeof(unsigned int));
+    set->hits = (char *) arena_alloc(arena, size * sizeof(char));
+
+    memset(set->slots, 0xff, size * sizeof(int));   //SET_EMPTY
+    memset(set->hits, FALSE, size * sizeof(char));
+}
+
+int set_slot(word_set *set, const char *word, int len, unsigned int hash) {
+    int mask = set->set_size - 1;
+    int slot = (int) (hash & (unsigned int) mask);
+
+    //linear probing, set is never full
+    while (set->slots[slot] != SET_EMPTY) {
+        word_span *span = &set->spans[set->slots[slot]];
+
+        if (set->hashes[slot] == hash && span->length == (unsigned int) len &&
+            memcmp(set->text + span->offset, word, len) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+int set_insert(word_set *set, int span) {
+    const char *word = set->text + set->spans[span].offset;
+    int len = (int) set->spans[span].length;
+    unsigned int hash = word_hash(word, len);
+    int slot = set_slot(set, word, len, hash);
+
+    if (set->slots[slot] != SET_EMPTY) {
+        return FALSE;
+    }
+
+    set->slots[slot] = span;
+    set->hashes[slot] = hash;
+    set->set_used++;
+    return TRUE;
 }
 
 #ifndef __PROGTEST__
 
+/**
+ * @param char* str
+ *
+ * str_format() as it was before format_chunk(), one string at a time, the oracle of format_fuzz()
+ */
+void str_format_reference(char *str) {
+    int i, j;
+
+    //remove extra whitespaces and lowercase all characters
+    for (i = j = 0; str[i]; ++i) {
+        unsigned char c = (unsigned char) str[i];
+
+        if ((!isspace(c) || (i > 0 && !isspace((unsigned char) str[i - 1]))) && (isalpha(c) || isspace(c))) {
+            str[j++] = (char) tolower(c);
+        }
+    }
+
+    str[j] = '\0';
+}
+
+/**
+ * @param format_fn impl
+ * @param int rounds
+ * @return int (TRUE|FALSE)
+ *
+ * compare impl to str_format_reference() on random strings split into random chunks, in place and into other buffer
+ */
+int format_fuzz(format_fn impl, int rounds) {
+    const char interesting[] = "aZ  \t\n\r\v\f.,'1@[`{\x80\xe9\xff";
+    char src[300], expected[301], out[300];
+
+    srand(1);
+    for (int r = 0; r < rounds; r++) {
+        size_t n = (size_t) (rand() % 260);
+
+        for (size_t i = 0; i < n; i++) {
+            src[i] = rand() % 2 ? interesting[rand() % (sizeof(interesting) - 1)] : (char) (rand() % 255 + 1);
+        }
+
+        memcpy(expected, src, n);
+        expected[n] = '\0';
+        str_format_reference(expected);
+        size_t expected_len = strlen(expected);
+        int prev_space = n == 0 || isspace((unsigned char) src[n - 1]);
+
+        //random chunks, prev_space carries over
+        size_t read = 0;
+        size_t len = 0;
+        int impl_prev_space = TRUE;
+        int in_place = rand() % 2;
+
+        if (in_place) {
+            memcpy(out, src, n);
+        }
+        while (read < n) {
+            size_t chunk = (size_t) (rand() % 100) + 1;
+            chunk = chunk > n - read ? n - read : chunk;
+
+            //in place output may only be packed within the chunk
+            if (in_place) {
+                memmove(out + len, out + read, chunk);
+                len += impl(out + len, out + len, chunk, &impl_prev_space);
+            } else {
+                len += impl(out + len, src + read, chunk, &impl_prev_space);
+            }
+            read += chunk;
+        }
+
+        if (len != expected_len || memcmp(out, expected, len) != 0 || impl_prev_space != prev_space) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @param int rounds
+ * @return int (TRUE|FALSE)
+ *
+ * add and remove random documents of a small vocabulary, compare LIBRARY_EXACT queries to sameWords() of the stored
+ * documents
+ */
+int library_churn(int rounds) {
+    const char *vocab[] = {"a", "b", "c", "d", "e", "f", "a long word that is not inline"};
+    char docs[64][128];
+    int stored[64] = {FALSE};
+    int ok = TRUE;
+    word_library library;
+
+    srand(3);
+    library_init(&library);
+    for (int r = 0; r < rounds && ok; r++) {
+        int doc = rand() % 64;
+        char query[128] = "";
+
+        for (int w = rand() % 4; w > 0; w--) {
+            strcat(query, vocab[rand() % 7]);
+            strcat(query, " ");
+        }
+
+        if (stored[doc]) {
+            ok = library_remove(&library, doc) == TRUE;
+            stored[doc] = FALSE;
+        } else if (rand() % 2) {
+            //free ids are reused last removed first, the document is stored under whatever id it gets
+            doc = library_add(&library, query);
+            ok = doc >= 0 && doc < 64 && !stored[doc];
+            if (ok) {
+                strcpy(docs[doc], query);
+                stored[doc] = TRUE;
+            }
+            continue;
+        }
+
+        int found_cnt;
+        int *found = library_query(&library, query, LIBRARY_EXACT, &found_cnt);
+        int k = 0;
+        for (int i = 0; i < 64 && ok; i++) {
+            if (stored[i] && sameWords(docs[i], query)) {
+                ok = k < found_cnt && found[k++] == i;
+            }
+        }
+        ok = ok && k == found_cnt;
+        free(found);
+    }
+    library_free(&library);
+
+    return ok;
+}
+
+#define CORPUS_RANDOM 0
+#define CORPUS_DUPLICATES 1
+#define CORPUS_PUNCTUATION 2
+#define CORPUS_WHITESPACE 3
+#define CORPUS_KINDS 4
+#define CORPUS_WORD_MAX 12
+#define BENCH_SECONDS 0.5
+
+const char *corpus_names[CORPUS_KINDS] = {"random", "duplicates", "punctuation", "whitespace"};
+
+//compares words of two strings, @see engines
+typedef int (*same_fn)(const char *a, const char *b);
+
+typedef struct engine {
+    const char *name;
+    same_fn fn;
+} engine;
+
+//growable string of generated corpus
+typedef struct corpus_buffer {
+    char *data;
+    size_t buffer_size;
+    size_t buffer_used;
+} corpus_buffer;
+
+/**
+ * @param unsigned long long* seed
+ * @return unsigned long long
+ *
+ * xorshift64*, seed must not be 0
+ */
+unsigned long long corpus_random(unsigned long long *seed) {
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+    return *seed * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @param corpus_buffer* buffer
+ * @param char c
+ */
+void corpus_append(corpus_buffer *buffer, char c) {
+    if (buffer->buffer_used + 1 >= buffer->buffer_size) {
+        buffer->buffer_size = buffer->buffer_size == 0 ? INIT_SIZE_ARR : 2 * buffer->buffer_size;
+        buffer->data = (char *) realloc(buffer->data, buffer->buffer_size);
+    }
+
+    buffer->data[buffer->buffer_used++] = c;
+    buffer->data[buffer->buffer_used] = '\0';
+}
+
+/**
+ * @param int kind
+ * @param const char* word
+ * @param unsigned long long* seed
+ * @param corpus_buffer* buffer
+ *
+ * append word with random case, noise of kind and a separator - the separator always starts with a space right after
+ * the word, so decoration never changes words (@see str_format())
+ */
+void corpus_word(int kind, const char *word, unsigned long long *seed, corpus_buffer *buffer) {
+    const char punctuation[] = ".,;:!?'\"()-0123456789";
+    const char whitespace[] = " \t\n";
+
+    for (const char *c = word; *c; c++) {
+        if (kind == CORPUS_PUNCTUATION && corpus_random(seed) % 4 == 0) {
+            corpus_append(buffer, punctuation[corpus_random(seed) % (sizeof(punctuation) - 1)]);
+        }
+        corpus_append(buffer, corpus_random(seed) % 8 == 0 ? (char) toupper(*c) : *c);
+    }
+    if (kind == CORPUS_PUNCTUATION && corpus_random(seed) % 2 == 0) {
+        corpus_append(buffer, punctuation[corpus_random(seed) % (sizeof(punctuation) - 1)]);
+    }
+
+    corpus_append(buffer, ' ');
+    if (kind == CORPUS_WHITESPACE) {
+        //mostly short runs, sometimes a huge one
+        int run = corpus_random(seed) % 64 == 0 ? 1024 : (int) (corpus_random(seed) % 16);
+
+        for (int i = 0; i < run; i++) {
+            corpus_append(buffer, whitespace[corpus_random(seed) % (sizeof(whitespace) - 1)]);
+        }
+    }
+}
+
+/**
+ * @param int kind
+ * @param size_t size
+ * @param int equal
+ * @param unsigned long long* seed
+ * @param char** a
+ * @param char** b
+ *
+ * generate strings a, b of about size bytes each - b has the words of a in random order,
+ * if !equal one word of b is replaced by a word a does not have
+ * a, b are dynamically allocated -> MUST BE FREED
+ */
+void corpus_pair(int kind, size_t size, int equal, unsigned long long *seed, char **a, char **b) {
+    int words_cnt = (int) (size / 8) + 1;
+    int vocab_cnt = kind == CORPUS_DUPLICATES ? 16 : words_cnt / 2 + 1;
+
+    //vocabulary of random lowercase words without 'z'
+    char (*vocab)[CORPUS_WORD_MAX + 1] = (char (*)[CORPUS_WORD_MAX + 1]) malloc(vocab_cnt * sizeof(*vocab));
+    for (int i = 0; i < vocab_cnt; i++) {
+        int len = (int) (corpus_random(seed) % CORPUS_WORD_MAX) + 1;
+
+        for (int j = 0; j < len; j++) {
+            vocab[i][j] = (char) ('a' + corpus_random(seed) % 25);
+        }
+        vocab[i][len] = '\0';
+    }
+
+    int *words = (int *) malloc(words_cnt * sizeof(int));
+    for (int i = 0; i < words_cnt; i++) {
+        words[i] = (int) (corpus_random(seed) % vocab_cnt);
+    }
+
+    corpus_buffer buffer_a = {NULL, 0, 0};
+    corpus_buffer buffer_b = {NULL, 0, 0};
+    corpus_append(&buffer_a, ' ');
+    corpus_append(&buffer_b, ' ');
+
+    for (int i = 0; i < words_cnt; i++) {
+        corpus_word(kind, vocab[words[i]], seed, &buffer_a);
+    }
+
+    //permute
+    for (int i = words_cnt - 1; i > 0; i--) {
+        int j = (int) (corpus_random(seed) % (i + 1));
+        int tmp = words[i];
+        words[i] = words[j];
+        words[j] = tmp;
+    }
+
+    int odd = equal ? -1 : (int) (corpus_random(seed) % words_cnt);
+    for (int i = 0; i < words_cnt; i++) {
+        corpus_word(kind, i == odd ? "z" : vocab[words[i]], seed, &buffer_b);
+    }
+
+    free(vocab);
+    free(words);
+    *a = buffer_a.data;
+    *b = buffer_b.data;
+}
+
+int engine_parallel(const char *a, const char *b) {
+    return sameWordsParallel(a, b, 4);
+}
+
+int engine_fingerprint(const char *a, const char *b) {
+    word_fingerprint fa = sameWordsFingerprint(a);
+    word_fingerprint fb = sameWordsFingerprint(b);
+
+    return fa.low == fb.low && fa.high == fb.high && fa.words == fb.words ? TRUE : FALSE;
+}
+
+//sameWordsStreams() on temporary files with a and b, sameWords() if there are no temporary files
+int engine_streams(const char *a, const char *b) {
+    FILE *file_a = tmpfile();
+    FILE *file_b = tmpfile();
+
+    if (file_a == NULL || file_b == NULL) {
+        if (file_a != NULL) {
+            fclose(file_a);
+        }
+        if (file_b != NULL) {
+            fclose(file_b);
+        }
+        return sameWords(a, b);
+    }
+
+    fputs(a, file_a);
+    fputs(b, file_b);
+    rewind(file_a);
+    rewind(file_b);
+
+    int cmp = sameWordsStreams(file_a, file_b);
+    fclose(file_a);
+    fclose(file_b);
+
+    return cmp;
+}
+
+/**
+ * @param const char* a
+ * @param const char* b
+ * @return int (TRUE|FALSE)
+ *
+ * write a and b to temporary files, return sameWordsStreams() of the files
+ */
+int files_check(const char *a, const char *b) {
+    return engine_streams(a, b);
+}
+
+//the first engine is the reference
+engine engines[] = {
+        {"sameWordsSorted",      sameWordsSorted},
+        {"sameWords",            sameWords},
+        {"sameWordsParallel",    engine_parallel},
+        {"sameWordsFingerprint", engine_fingerprint},
+        {"sameWordsStreams",     engine_streams},
+        {"sameWordsRadix",       sameWordsRadix},
+};
+
+#define ENGINES_CNT ((int) (sizeof(engines) / sizeof(engines[0])))
+
+/**
+ * @param int rounds
+ * @return int (TRUE|FALSE)
+ *
+ * compare every engine to the reference on generated pairs and on random strings of interesting chars,
+ * print the first difference
+ */
+int fuzz(int rounds) {
+    const char interesting[] = "aAbZ  \t\n\r.,'1@\x80\xe9";
+    unsigned long long seed = 1;
+
+    for (int r = 0; r < rounds; r++) {
+        char *a;
+        char *b;
+        int kind = (int) (corpus_random(&seed) % (CORPUS_KINDS + 1));
+        size_t size = (size_t) (corpus_random(&seed) % 200);
+
+        if (kind < CORPUS_KINDS) {
+            corpus_pair(kind, size, (int) (corpus_random(&seed) % 2), &seed, &a, &b);
+        } else {
+            //b is a with some chars changed
+            a = (char *) malloc(size + 1);
+            b = (char *) malloc(size + 1);
+            for (size_t i = 0; i < size; i++) {
+                a[i] = interesting[corpus_random(&seed) % (sizeof(interesting) - 1)];
+                b[i] = corpus_random(&seed) % 8 == 0 ? interesting[corpus_random(&seed) % (sizeof(interesting) - 1)]
+                                                     : a[i];
+            }
+            a[size] = '\0';
+            b[size] = '\0';
+        }
+
+        int expected = engines[0].fn(a, b);
+        for (int e = 1; e < ENGINES_CNT; e++) {
+            if (engines[e].fn(a, b) != expected) {
+                printf("%s differs from %s in round %d (%s): \"%s\" \"%s\"\n", engines[e].name, engines[0].name, r,
+                       kind < CORPUS_KINDS ? corpus_names[kind] : "chars", a, b);
+                free(a);
+                free(b);
+                return FALSE;
+            }
+        }
+
+        free(a);
+        free(b);
+    }
+
+    return TRUE;
+}
+
+double bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * @param size_t size
+ *
+ * print MB/s (both strings) and heap allocations per call of every engine on equal and different pairs of every
+ * corpus kind, strings have about size bytes each
+ */
+void bench(size_t size) {
+    unsigned long long seed = 1;
+
+    printf("%-12s %-6s %-22s %12s %14s\n", "corpus", "equal", "engine", "MB/s", "allocs/call");
+    for (int kind = 0; kind < CORPUS_KINDS; kind++) {
+        for (int equal = TRUE; equal >= FALSE; equal--) {
+            char *a;
+            char *b;
+            corpus_pair(kind, size, equal, &seed, &a, &b);
+            double mb = (double) (strlen(a) + strlen(b)) / 1e6;
+
+            for (int e = 0; e < ENGINES_CNT; e++) {
+                int calls = 0;
+                int cmp = 0;
+                alloc_cnt = 0;
+                double start = bench_now();
+                double elapsed;
+
+                do {
+                    cmp = engines[e].fn(a, b);
+                    calls++;
+                    elapsed = bench_now() - start;
+                } while (elapsed < BENCH_SECONDS);
+
+                printf("%-12s %-6s %-22s %12.1f %14.1f%s\n", corpus_names[kind], equal ? "yes" : "no",
+                       engines[e].name, mb * calls / elapsed, (double) alloc_cnt / calls,
+                       cmp != equal ? "  WRONG RESULT" : "");
+            }
+
+            free(a);
+            free(b);
+        }
+    }
+}
+
 int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--fuzz") == 0) {
+        int rounds = 100000;
+
+        if (argc > 2 && (sscanf(argv[2], "%d", &rounds) != 1 || rounds < 1)) {
+            printf("usage: %s --fuzz [rounds]\n", argv[0]);
+            return 1;
+        }
+        if (!fuzz(rounds)) {
+            return 1;
+        }
+        printf("%d rounds OK\n", rounds);
+        return 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int mb = 4;
+
+        if (argc > 2 && (sscanf(argv[2], "%d", &mb) != 1 || mb < 1)) {
+            printf("usage: %s --bench [MB]\n", argv[0]);
+            return 1;
+        }
+        bench((size_t) mb * 1000000);
+        return 0;
+    }
+
     assert(sameWords(
             "              HAPBqYQDmPqJulDVBYOyl ZvCruEhdxBqAzcXmcbp  VpxZEVzzaAHbPW   kpMkTCpuCiOMarCVLs    TwudVyKwFtAhibSaMl     SaLqpXWjMGTzOWZtN      nesGJGhCLc       xUkxNb        TjvjeaiThBLnLnSEOcx DqoAikfpfpOogestMz  dVZHiP   SqJAUksuDQXuLKVFFjHXoY    jrx     ROcFzqkOWbPuwfUPion      wR       anKKMzZZrLSaSSwtPAsYWwm        fQbmrxpeiskgWNCMM pbl  ghDjMwzkOxni   ",
             "             ZvCruEhdxBqAzcXmcbp wR  kpMkTCpuCiOMarCVLs   DqoAikfpfpOogestMz    pbl     fQbmrxpeiskgWNCMM      anKKMzZZrLSaSSwtPAsYWwm       jrx        SqJAUksuDQXuLKVFFjHXoY VpxZEVzzaAHbPW  dVZHiP   TjvjeaiThBLnLnSEOcx    xUkxNb     ROcFzqkOWbPuwfUPion      HAPBqYQDmPqJulDVBYOyl       nesGJGhCLc        SaLqpXWjMGTzOWZtN TwudVyKwFtAhibSaMl  ghDjMwzkOxni   ") ==
@@ -276,6 +3268,226 @@ int main(int argc, char *argv[]) {
            1);
     assert(sameWords("He said he would do it.", "IT said: 'He would do it.'") == 1);
     assert(sameWords("one two three", "one two five") == 0);
+    assert(sameWords("one two three", "three two one two") == 1);
+    assert(sameWords("one two", "one two three") == 0);
+    assert(sameWords("", "  ...  ") == 1);
+    assert(sameWords("", "a") == 0);
+    assert(sameWords("a\tb", "a\t b") == 1);
+    assert(sameWords("a\tb", "a \tb") == 0);
+    assert(sameWordsSorted("He said he would do it.", "IT said: 'He would do it.'") == 1);
+    assert(sameWordsSorted("one two three", "one two five") == 0);
+    assert(sameWordsSorted("a\tb", "a \tb") == 0);
+
+    word_fingerprint fa = sameWordsFingerprint("He said he would do it.");
+    word_fingerprint fb = sameWordsFingerprint("IT said: 'He would do it.'");
+    word_fingerprint fc = sameWordsFingerprint("one two three");
+    word_fingerprint fd = sameWordsFingerprint("one two five");
+    assert(fa.low == fb.low && fa.high == fb.high && fa.words == fb.words && fa.words == 5);
+    assert(fc.low != fd.low || fc.high != fd.high);
+
+    const char *docs[] = {"one two three", "He said he would do it.", "three  two ONE one", "one two five",
+                          "IT said: 'He would do it.'", ""};
+    int groups[6];
+    int groups_cnt = sameWordsGroups(docs, 6, groups);
+    assert(groups_cnt == 4);
+    assert(groups[0] == 0 && groups[1] == 1 && groups[2] == 0 && groups[3] == 3 && groups[4] == 1 && groups[5] == 5);
+
+    unsigned long long signatures[4 * 64];
+    sameWordsMinHash("He said he would do it.", 64, signatures);
+    sameWordsMinHash("IT said: 'He would do it.'", 64, signatures + 64);
+    sameWordsMinHash("one two three four five six seven eight nine ten", 64, signatures + 128);
+    sameWordsMinHash("one two three four five six seven eight nine eleven", 64, signatures + 192);
+    assert(sameWordsSimilarity(signatures, signatures + 64, 64) == 1.0);
+    assert(sameWordsSimilarity(signatures, signatures + 128, 64) < 0.2);
+
+    int pairs_cnt;
+    int *pairs = sameWordsCandidates(signatures, 4, 64, 16, &pairs_cnt);
+    assert(pairs_cnt >= 1 && pairs[0] == 0 && pairs[1] == 1);
+    free(pairs);
+
+    assert(files_check("He said he would do it.", "IT said: 'He would do it.'") == TRUE);
+    assert(files_check("one two three", "one two five") == FALSE);
+    assert(files_check("", "  ") == TRUE);
+    assert(files_check("", "a") == FALSE);
+    assert(sameWordsFiles("/nonexistent/a", "/nonexistent/b") == FILE_ERROR);
+
+    //"boundary" is split by the first chunk boundary after "boun", it must not become "boun" and "dary"
+    char *split = (char *) malloc(FILE_CHUNK + 16);
+    for (int i = 0; i < FILE_CHUNK - 5; i++) {
+        split[i] = "ab "[i % 3];
+    }
+    strcpy(split + FILE_CHUNK - 5, " boundary cd");
+    assert(files_check(split, "cd boundary ab") == TRUE);
+    assert(files_check("ab cd boun dary", split) == FALSE);
+    assert(files_check(split, "ab cd boun") == FALSE);
+    free(split);
+
+    //words crossing chunk boundaries, word longer than a chunk
+    char *long_a = (char *) malloc(5 * FILE_CHUNK + 1);
+    char *long_b = (char *) malloc(5 * FILE_CHUNK + 1);
+    for (int i = 0; i < 5 * FILE_CHUNK; i++) {
+        long_a[i] = i < 3 * FILE_CHUNK ? "abc de.fgh  "[i % 12] : 'x';
+        long_b[i] = i < 3 * FILE_CHUNK ? "abc de.fgh  "[(i + 4) % 12] : 'x';
+    }
+    long_a[5 * FILE_CHUNK] = '\0';
+    long_b[5 * FILE_CHUNK] = '\0';
+    //same words, shifted against the chunk boundaries
+    assert(files_check(long_a, long_b) == TRUE);
+    long_b[5 * FILE_CHUNK - 1] = 'y';
+    assert(files_check(long_a, long_b) == FALSE);
+    free(long_a);
+    free(long_b);
+
+    for (int threads = 1; threads <= 4; threads++) {
+        assert(sameWordsParallel("He said he would do it.", "IT said: 'He would do it.'", threads) == 1);
+        assert(sameWordsParallel("one two three", "one two five", threads) == 0);
+        assert(sameWordsParallel("a\t b c", "c a\tb", threads) == 1);
+        assert(sameWordsParallel("", "", threads) == 1);
+        assert(sameWordsParallel("", "a", threads) == 0);
+    }
+
+#ifdef WORDS_THREADS
+    //jobs whose threads fail to start run on the calling thread, the differing word is in the last range
+    for (threads_left = 0; threads_left <= 3; threads_left++) {
+        int left = threads_left;
+
+        assert(sameWordsParallel("one two three four five six seven", "seven six five four three two one", 4) == 1);
+        threads_left = left;
+        assert(sameWordsParallel("one two three four five six seven", "one two three four five six eight", 4) == 0);
+        threads_left = left;
+    }
+    threads_left = -1;
+#endif
+
+    assert(sameWordsRadix("He said he would do it.", "IT said: 'He would do it.'") == 1);
+    assert(sameWordsRadix("one two three", "one two five") == 0);
+    assert(sameWordsRadix("a\tb", "a \tb") == 0);
+
+    word_arena vocab_arena;
+    char *vocab_text;
+    word_span *vocab_spans;
+    int vocab_cnt = tokenize_sorted("b a ab b ba a aa", &vocab_arena, &vocab_text, &vocab_spans);
+    assert(vocab_cnt == 5);
+    assert(strncmp(vocab_text + vocab_spans[0].offset, "a", vocab_spans[0].length) == 0);
+    assert(strncmp(vocab_text + vocab_spans[2].offset, "ab", vocab_spans[2].length) == 0);
+    assert(strncmp(vocab_text + vocab_spans[4].offset, "ba", vocab_spans[4].length) == 0);
+    arena_free(&vocab_arena);
+
+    word_table table;
+    table_init(&table, 2);
+    int table_ids[4];
+    table_ids[0] = table_insert(&table, "one", 3);
+    table_ids[1] = table_insert(&table, "a much longer word than fits in a slot", 38);
+    table_ids[2] = table_insert(&table, "two", 3);
+    table_ids[3] = table_insert(&table, "one", 3);
+    assert(table_ids[0] == 0 && table_ids[1] == 1 && table_ids[2] == 2 && table_ids[3] == 0);
+    assert(table_size(&table) == 3);
+    assert(table_contains(&table, "a much longer word than fits in a slot", 38) == TRUE);
+    assert(table_contains(&table, "on", 2) == FALSE);
+    int table_pos = 0;
+    int table_words = 0;
+    const table_entry *entry;
+    while ((entry = table_next(&table, &table_pos)) != NULL) {
+        assert(table_lookup(&table, table_text(&table, entry), (int) entry->length) == entry->id);
+        table_words++;
+    }
+    assert(table_words == 3);
+    table_clear(&table);
+    assert(table_size(&table) == 0 && table_contains(&table, "one", 3) == FALSE);
+    table_free(&table);
+
+    word_library library;
+    int *found;
+    int found_cnt;
+    int library_ids[5];
+    int library_removed[2];
+    library_init(&library);
+    library_ids[0] = library_add(&library, "one two three");
+    library_ids[1] = library_add(&library, "He said he would do it.");
+    library_ids[2] = library_add(&library, "three two ONE one");
+    library_ids[3] = library_add(&library, "one two");
+    library_ids[4] = library_add(&library, "...");
+    assert(library_ids[0] == 0 && library_ids[1] == 1 && library_ids[2] == 2 && library_ids[3] == 3 &&
+           library_ids[4] == 4);
+    found = library_query(&library, "two one three", LIBRARY_EXACT, &found_cnt);
+    assert(found_cnt == 2 && found[0] == 0 && found[1] == 2);
+    free(found);
+    found = library_query(&library, "one", LIBRARY_SUPERSET, &found_cnt);
+    assert(found_cnt == 3 && found[0] == 0 && found[1] == 2 && found[2] == 3);
+    free(found);
+    found = library_query(&library, "one two four", LIBRARY_SUBSET, &found_cnt);
+    assert(found_cnt == 2 && found[0] == 3 && found[1] == 4);
+    free(found);
+    library_removed[0] = library_remove(&library, 0);
+    library_removed[1] = library_remove(&library, 0);
+    assert(library_removed[0] == TRUE && library_removed[1] == FALSE);
+    found = library_query(&library, "one two three", LIBRARY_EXACT, &found_cnt);
+    assert(found_cnt == 1 && found[0] == 2);
+    free(found);
+    found = library_query(&library, "", LIBRARY_EXACT, &found_cnt);
+    assert(found_cnt == 1 && found[0] == 4);
+    free(found);
+    //id of the removed document is reused, words only removed documents had are dropped
+    library_ids[0] = library_add(&library, "two three");
+    library_ids[1] = library_add(&library, "seven");
+    assert(library_ids[0] == 0 && library_ids[1] == 5);
+    library_removed[0] = library_remove(&library, 1);
+    library_removed[1] = library_remove(&library, 2);
+    assert(library_removed[0] == TRUE && library_removed[1] == TRUE);
+    assert(table_size(&library.words) == 4 && table_contains(&library.words, "would", 5) == FALSE);
+    found = library_query(&library, "one two", LIBRARY_SUPERSET, &found_cnt);
+    assert(found_cnt == 1 && found[0] == 3);
+    free(found);
+    found = library_query(&library, "three two", LIBRARY_EXACT, &found_cnt);
+    assert(found_cnt == 1 && found[0] == 0);
+    free(found);
+    library_free(&library);
+
+    assert(library_churn(20000) == TRUE);
+
+    const char *edited = "one two three";
+    word_tracker tracker;
+    tracker_init(&tracker, edited, "three two one two");
+    int edits[4];
+    assert(tracker_same(&tracker) == TRUE);
+    edits[0] = tracker_insert(&tracker, TRACKER_A, "four");
+    assert(edits[0] == TRUE && tracker_same(&tracker) == FALSE);
+    edits[0] = tracker_insert(&tracker, TRACKER_B, "Four!");
+    assert(edits[0] == TRUE && tracker_same(&tracker) == TRUE);
+    edits[0] = tracker_delete(&tracker, TRACKER_B, "two two");
+    assert(edits[0] == TRUE && tracker_same(&tracker) == FALSE);
+    edits[0] = tracker_delete(&tracker, TRACKER_B, "five");
+    edits[1] = tracker_delete(&tracker, TRACKER_B, "one one");
+    edits[2] = tracker_insert(&tracker, TRACKER_B, "two");
+    assert(edits[0] == FALSE && edits[1] == FALSE && edits[2] == TRUE && tracker_same(&tracker) == TRUE);
+    //"one two three" -> "one twenty three"
+    edits[0] = tracker_replace(&tracker, TRACKER_A, edited, 13, 5, 7, "wenty");
+    assert(edits[0] == TRUE && tracker_same(&tracker) == FALSE);
+    edits[0] = tracker_replace(&tracker, TRACKER_A, "one twenty three", 16, 5, 10, "wo");
+    assert(edits[0] == TRUE && tracker_same(&tracker) == TRUE);
+    //range past the end of text (also an empty one), reversed range, words the document does not have
+    char *short_text = (char *) malloc(4);
+    strcpy(short_text, "abc");
+    edits[0] = tracker_replace(&tracker, TRACKER_A, "one two three", 13, 5, 20, "x");
+    edits[1] = tracker_replace(&tracker, TRACKER_A, short_text, 3, 10, 10, "x");
+    edits[2] = tracker_replace(&tracker, TRACKER_A, "one two three", 13, 7, 5, "x");
+    edits[3] = tracker_replace(&tracker, TRACKER_A, "one six three", 13, 4, 7, "two");
+    assert(edits[0] == FALSE && edits[1] == FALSE && edits[2] == FALSE && edits[3] == FALSE);
+    assert(tracker_same(&tracker) == TRUE);
+    free(short_text);
+    tracker_free(&tracker);
+
+    //every format_chunk() kernel must produce the same output as the original str_format()
+    assert(format_fuzz(format_chunk, 100000) == TRUE);
+    assert(format_fuzz(format_chunk_scalar, 100000) == TRUE);
+#ifdef FORMAT_SIMD
+    assert(format_fuzz(format_chunk_sse2, 100000) == TRUE);
+    if (__builtin_cpu_supports("avx2")) {
+        assert(format_fuzz(format_chunk_avx2, 100000) == TRUE);
+    }
+#endif
+
+    assert(fuzz(2000) == TRUE);
     return 0;
 }
 